@@ -1,27 +1,40 @@
 #include "audio_bridge.h"
 #include "../include/AudioEngine.h"
 #include "../include/CommandProcessor.h"
+#include "../include/TelemetryPublisher.h"
 
 //==============================================================================
 // AudioBridge Implementation
 //==============================================================================
 
 AudioBridge::AudioBridge() 
-    : eventEnv(nullptr), eventCallbackRef(nullptr)
+    : telemetryEnv(nullptr), telemetryBufferRef(nullptr),
+      droppedEvents(0), drainScheduled(false), eventFunction(nullptr)
 {
     audioEngine = std::make_unique<AudioEngine>();
     commandProcessor = std::make_unique<CommandProcessor>(audioEngine.get());
+    telemetryPublisher = std::make_unique<TelemetryPublisher>(*audioEngine);
+    
+    pendingEvents.reserve(MAX_PENDING_EVENTS);
+    deliveringEvents.reserve(MAX_PENDING_EVENTS);
+    
+    // Wired once; whether anything reaches JS depends on eventFunction
+    commandProcessor->setEventCallback([this](const juce::String& eventType, const juce::var& eventData) {
+        this->onAudioEvent(eventType, eventData);
+    });
 }
 
 AudioBridge::~AudioBridge()
 {
     shutdown();
+    releaseTelemetryBuffer();
     
-    // Clean up event callback reference
-    if (eventEnv && eventCallbackRef) {
-        napi_delete_reference(eventEnv, eventCallbackRef);
-        eventCallbackRef = nullptr;
-    }
+    // Stop the engine's event thread before the queue it feeds goes away
+    telemetryPublisher.reset();
+    commandProcessor.reset();
+    audioEngine.reset();
+    
+    releaseEventFunction();
 }
 
 bool AudioBridge::initialize()
@@ -79,37 +92,183 @@ napi_value AudioBridge::processCommandVar(napi_env env, napi_value commandObj)
 
 void AudioBridge::setEventCallback(napi_env env, napi_value callback)
 {
-    eventEnv = env;
+    releaseEventFunction();
     
-    // Clean up existing reference
-    if (eventCallbackRef) {
-        napi_delete_reference(env, eventCallbackRef);
-    }
+    napi_value resourceName = nullptr;
+    napi_threadsafe_function function = nullptr;
+    NAPI_CALL_RETURN_VOID(env, napi_create_string_utf8(env, "CueForgeEvents", NAPI_AUTO_LENGTH, &resourceName));
     
-    // Create new reference
-    napi_status status = napi_create_reference(env, callback, 1, &eventCallbackRef);
+    napi_status status = napi_create_threadsafe_function(env, callback, nullptr, resourceName,
+                                                         0, 1, nullptr, nullptr, this,
+                                                         callJavaScriptCallback, &function);
     if (status != napi_ok) {
-        napi_throw_error(env, nullptr, "Failed to create callback reference");
+        napi_throw_error(env, nullptr, "Failed to create event callback");
         return;
     }
     
-    // Set up the callback with CommandProcessor
-    commandProcessor->setEventCallback([this](const juce::String& eventType, const juce::var& eventData) {
-        this->onAudioEvent(eventType, eventData);
-    });
+    // Pending events must not keep the process alive
+    napi_unref_threadsafe_function(env, function);
+    
+    juce::ScopedLock lock(pendingEventLock);
+    pendingEvents.clear();
+    droppedEvents = 0;
+    drainScheduled = false;
+    eventFunction = function;
+}
+
+void AudioBridge::releaseEventFunction()
+{
+    napi_threadsafe_function function = nullptr;
+    {
+        juce::ScopedLock lock(pendingEventLock);
+        function = eventFunction;
+        eventFunction = nullptr;
+        pendingEvents.clear();
+        drainScheduled = false;
+    }
+    
+    if (function != nullptr) {
+        napi_release_threadsafe_function(function, napi_tsfn_abort);
+    }
+}
+
+napi_value AudioBridge::createTelemetryBuffer(napi_env env, int maxCues)
+{
+    // Channel counts may have changed since the last buffer, so start afresh
+    releaseTelemetryBuffer();
+    
+    // V8-allocated rather than external memory: Electron's memory cage
+    // rejects external ArrayBuffers. The reference pins it until release.
+    const size_t numBytes = telemetryPublisher->getRequiredBytes(maxCues);
+    void* data = nullptr;
+    napi_value arrayBuffer = nullptr;
+    NAPI_CALL(env, napi_create_arraybuffer(env, numBytes, &data, &arrayBuffer));
+    NAPI_CALL(env, napi_create_reference(env, arrayBuffer, 1, &telemetryBufferRef));
+    telemetryEnv = env;
+    
+    if (!telemetryPublisher->attach(data, numBytes, maxCues)) {
+        releaseTelemetryBuffer();
+        napi_throw_error(env, nullptr, "Failed to attach telemetry buffer");
+        return nullptr;
+    }
+    
+    return arrayBuffer;
+}
+
+napi_value AudioBridge::getTelemetryCueIds(napi_env env)
+{
+    juce::int32 generation = 0;
+    const juce::StringArray cueIds = telemetryPublisher->getCueIds(generation);
+    
+    napi_value result = nullptr;
+    napi_value ids = nullptr;
+    napi_value generationValue = nullptr;
+    NAPI_CALL(env, napi_create_object(env, &result));
+    NAPI_CALL(env, napi_create_array_with_length(env, static_cast<size_t>(cueIds.size()), &ids));
+    
+    for (int slot = 0; slot < cueIds.size(); ++slot) {
+        NAPI_CALL(env, napi_set_element(env, ids, static_cast<uint32_t>(slot), juceStringToNapi(env, cueIds[slot])));
+    }
+    
+    NAPI_CALL(env, napi_create_int32(env, generation, &generationValue));
+    NAPI_CALL(env, napi_set_named_property(env, result, "generation", generationValue));
+    NAPI_CALL(env, napi_set_named_property(env, result, "cueIds", ids));
+    return result;
+}
+
+void AudioBridge::releaseTelemetryBuffer()
+{
+    // Stop writing before the buffer can be collected
+    if (telemetryPublisher) {
+        telemetryPublisher->detach();
+    }
+    
+    if (telemetryEnv && telemetryBufferRef) {
+        napi_delete_reference(telemetryEnv, telemetryBufferRef);
+    }
+    telemetryBufferRef = nullptr;
+    telemetryEnv = nullptr;
 }
 
 void AudioBridge::onAudioEvent(const juce::String& eventType, const juce::var& eventData)
 {
-    if (eventEnv && eventCallbackRef) {
-        callJavaScriptCallback(eventType, eventData);
+    // Engine event thread
+    juce::ScopedLock lock(pendingEventLock);
+    if (eventFunction == nullptr) {
+        return;
+    }
+    
+    const juce::String cueId = eventData.getProperty("cueId", juce::var()).toString();
+    if (cueId.isNotEmpty()) {
+        for (auto it = pendingEvents.begin(); it != pendingEvents.end(); ++it) {
+            if (it->type == eventType && it->data.getProperty("cueId", juce::var()).toString() == cueId) {
+                pendingEvents.erase(it);
+                break;
+            }
+        }
+    }
+    
+    if (static_cast<int>(pendingEvents.size()) >= MAX_PENDING_EVENTS) {
+        pendingEvents.erase(pendingEvents.begin());
+        ++droppedEvents;
+    }
+    
+    pendingEvents.push_back({eventType, eventData});
+    
+    if (!drainScheduled) {
+        drainScheduled = napi_call_threadsafe_function(eventFunction, nullptr, napi_tsfn_nonblocking) == napi_ok;
     }
 }
 
-void AudioBridge::callJavaScriptCallback(const juce::String& eventType, const juce::var& eventData)
+void AudioBridge::callJavaScriptCallback(napi_env env, napi_value callback, void* context, void*)
 {
-    // In a full implementation, this would need proper thread handling
-    // For now, this is a placeholder for the event system
+    // A null env means the function is being torn down
+    if (env != nullptr && callback != nullptr) {
+        static_cast<AudioBridge*>(context)->deliverPendingEvents(env, callback);
+    }
+}
+
+void AudioBridge::deliverPendingEvents(napi_env env, napi_value callback)
+{
+    int dropped = 0;
+    {
+        juce::ScopedLock lock(pendingEventLock);
+        deliveringEvents.swap(pendingEvents);
+        dropped = droppedEvents;
+        droppedEvents = 0;
+        drainScheduled = false;
+    }
+    
+    if (dropped > 0) {
+        juce::DynamicObject::Ptr data = new juce::DynamicObject();
+        data->setProperty("count", dropped);
+        deliveringEvents.insert(deliveringEvents.begin(), {"eventsDropped", juce::var(data.get())});
+    }
+    
+    napi_value undefined = nullptr;
+    napi_get_undefined(env, &undefined);
+    
+    for (const auto& event : deliveringEvents) {
+        napi_handle_scope scope = nullptr;
+        if (napi_open_handle_scope(env, &scope) != napi_ok) {
+            break;
+        }
+        
+        napi_value args[2] = { juceStringToNapi(env, event.type), juceVarToNapi(env, event.data) };
+        napi_value result = nullptr;
+        
+        // A throwing handler is reported like any uncaught exception and the
+        // rest of the batch is still delivered
+        if (napi_call_function(env, undefined, callback, 2, args, &result) == napi_pending_exception) {
+            napi_value exception = nullptr;
+            napi_get_and_clear_last_exception(env, &exception);
+            napi_fatal_exception(env, exception);
+        }
+        
+        napi_close_handle_scope(env, scope);
+    }
+    
+    deliveringEvents.clear();
 }
 
 //==============================================================================
@@ -127,9 +286,13 @@ napi_value AudioBridge::juceVarToNapi(napi_env env, const juce::var& value)
     else if (value.isBool()) {
         status = napi_get_boolean(env, static_cast<bool>(value), &result);
     }
-    else if (value.isInt() || value.isInt64()) {
+    else if (value.isInt()) {
         status = napi_create_int32(env, static_cast<int32_t>(value), &result);
     }
+    else if (value.isInt64()) {
+        // Sample clocks pass 2^31 after hours; JS numbers hold them exactly up to 2^53
+        status = napi_create_int64(env, static_cast<int64_t>(static_cast<juce::int64>(value)), &result);
+    }
     else if (value.isDouble()) {
         status = napi_create_double(env, static_cast<double>(value), &result);
     }
@@ -294,6 +457,125 @@ napi_value AudioBridge::juceStringToNapi(napi_env env, const juce::String& str)
 
 static std::unique_ptr<AudioBridge> g_audioBridge;
 
+//==============================================================================
+// Fast-path argument helpers
+//==============================================================================
+
+namespace
+{
+    // Reads positional arguments for the typed exports. Every reader throws a
+    // JS TypeError and returns false on a mismatch, so callers just bail out.
+    template <size_t MaxArgs>
+    class FastArgs
+    {
+    public:
+        FastArgs(napi_env environment, napi_callback_info info) : env(environment)
+        {
+            napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+        }
+        
+        AudioEngine* engine() const
+        {
+            AudioEngine* audioEngine = g_audioBridge ? g_audioBridge->getEngine() : nullptr;
+            if (audioEngine == nullptr) {
+                napi_throw_error(env, nullptr, "AudioEngine not initialized");
+            }
+            return audioEngine;
+        }
+        
+        bool number(size_t index, double& value) const
+        {
+            return (index < argc && napi_get_value_double(env, argv[index], &value) == napi_ok)
+                || fail("Expected a number", index);
+        }
+        
+        bool integer(size_t index, int32_t& value) const
+        {
+            return (index < argc && napi_get_value_int32(env, argv[index], &value) == napi_ok)
+                || fail("Expected an integer", index);
+        }
+        
+        bool boolean(size_t index, bool& value) const
+        {
+            return (index < argc && napi_get_value_bool(env, argv[index], &value) == napi_ok)
+                || fail("Expected a boolean", index);
+        }
+        
+        bool optionalBoolean(size_t index, bool& value) const
+        {
+            return isNullish(index) || boolean(index, value);
+        }
+        
+        bool cueId(size_t index, juce::String& value) const
+        {
+            if (isNullish(index)) {
+                value = {};
+                return true;
+            }
+            
+            napi_valuetype type = napi_undefined;
+            napi_typeof(env, argv[index], &type);
+            if (type != napi_string) {
+                return fail("Expected a cue id string or null", index);
+            }
+            
+            value = AudioBridge::napiStringToJuce(env, argv[index]);
+            return true;
+        }
+        
+        bool floatArray(size_t index, const float*& data, size_t& length) const
+        {
+            bool isTypedArray = false;
+            if (index < argc && napi_is_typedarray(env, argv[index], &isTypedArray) == napi_ok && isTypedArray) {
+                napi_typedarray_type type = napi_int8_array;
+                void* elements = nullptr;
+                if (napi_get_typedarray_info(env, argv[index], &type, &length, &elements, nullptr, nullptr) == napi_ok
+                    && type == napi_float32_array) {
+                    data = static_cast<const float*>(elements);
+                    return true;
+                }
+            }
+            return fail("Expected a Float32Array", index);
+        }
+        
+    private:
+        napi_env env;
+        size_t argc = MaxArgs;
+        napi_value argv[MaxArgs] = {};
+        
+        bool isNullish(size_t index) const
+        {
+            if (index >= argc) {
+                return true;
+            }
+            napi_valuetype type = napi_undefined;
+            napi_typeof(env, argv[index], &type);
+            return type == napi_undefined || type == napi_null;
+        }
+        
+        bool fail(const char* message, size_t index) const
+        {
+            const juce::String text = juce::String(message) + " for argument " + juce::String(static_cast<int>(index));
+            napi_throw_type_error(env, nullptr, text.toRawUTF8());
+            return false;
+        }
+    };
+    
+    napi_value makeBoolean(napi_env env, bool value)
+    {
+        napi_value result = nullptr;
+        napi_get_boolean(env, value, &result);
+        return result;
+    }
+    
+    napi_value makeNumber(napi_env env, double value)
+    {
+        napi_value result = nullptr;
+        napi_create_double(env, value, &result);
+        return result;
+    }
+}
+
 //==============================================================================
 // N-API C-Style Exports
 //==============================================================================
@@ -305,6 +587,9 @@ napi_value Init(napi_env env, napi_value exports)
     // Create the global AudioBridge instance
     g_audioBridge = std::make_unique<AudioBridge>();
     
+    // Tear down while the environment can still release its N-API handles
+    napi_add_env_cleanup_hook(env, [](void*) { g_audioBridge.reset(); }, nullptr);
+    
     // Define the AudioEngine constructor
     napi_value cons = nullptr;
     napi_define_class(env, "AudioEngine", NAPI_AUTO_LENGTH, CreateAudioEngine, 
@@ -318,6 +603,20 @@ napi_value Init(napi_env env, napi_value exports)
         {"getStatus", nullptr, AudioEngine_GetStatus, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"processCommand", nullptr, AudioEngine_ProcessCommand, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"setEventCallback", nullptr, AudioEngine_SetEventCallback, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getTelemetryBuffer", nullptr, AudioEngine_GetTelemetryBuffer, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getTelemetryCueIds", nullptr, AudioEngine_GetTelemetryCueIds, nullptr, nullptr, nullptr, napi_default, nullptr},
+        
+        // Typed fast path for high-rate control (faders, matrix edits)
+        {"setCrosspoint", nullptr, AudioEngine_SetCrosspoint, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getCrosspoint", nullptr, AudioEngine_GetCrosspoint, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"setInputLevel", nullptr, AudioEngine_SetInputLevel, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"setOutputLevel", nullptr, AudioEngine_SetOutputLevel, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"muteOutput", nullptr, AudioEngine_MuteOutput, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"soloOutput", nullptr, AudioEngine_SoloOutput, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"setMatrix", nullptr, AudioEngine_SetMatrix, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"setPatchRouting", nullptr, AudioEngine_SetPatchRouting, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getPatchRouting", nullptr, AudioEngine_GetPatchRouting, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"setPatchFusion", nullptr, AudioEngine_SetPatchFusion, nullptr, nullptr, nullptr, napi_default, nullptr},
     };
     
     napi_define_properties(env, exports, sizeof(desc) / sizeof(desc[0]), desc);
@@ -414,6 +713,47 @@ napi_value AudioEngine_SetEventCallback(napi_env env, napi_callback_info info)
     return undefined;
 }
 
+napi_value AudioEngine_GetTelemetryBuffer(napi_env env, napi_callback_info info)
+{
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    
+    if (!g_audioBridge) {
+        napi_throw_error(env, nullptr, "AudioEngine not initialized");
+        return nullptr;
+    }
+    
+    // Optional slot capacity for cue playheads. Read as a double so values
+    // beyond int32 are rejected rather than wrapped into range
+    double maxCues = TelemetryPublisher::DEFAULT_MAX_CUES;
+    if (argc >= 1) {
+        napi_valuetype type = napi_undefined;
+        napi_typeof(env, args[0], &type);
+        if (type == napi_number) {
+            napi_get_value_double(env, args[0], &maxCues);
+        }
+    }
+    
+    if (!(maxCues >= 0.0 && maxCues <= TelemetryPublisher::MAX_CUES)) {
+        const juce::String message = "maxCues must be between 0 and " + juce::String(TelemetryPublisher::MAX_CUES);
+        napi_throw_range_error(env, nullptr, message.toRawUTF8());
+        return nullptr;
+    }
+    
+    return g_audioBridge->createTelemetryBuffer(env, static_cast<int>(maxCues));
+}
+
+napi_value AudioEngine_GetTelemetryCueIds(napi_env env, napi_callback_info info)
+{
+    if (!g_audioBridge) {
+        napi_throw_error(env, nullptr, "AudioEngine not initialized");
+        return nullptr;
+    }
+    
+    return g_audioBridge->getTelemetryCueIds(env);
+}
+
 // Placeholder implementations for other exported functions
 napi_value AudioEngine_SetAudioDevice(napi_env env, napi_callback_info info) { 
     napi_value undefined = nullptr;
@@ -469,52 +809,157 @@ napi_value AudioEngine_StopAllCues(napi_env env, napi_callback_info info) {
     return undefined;
 }
 
-napi_value AudioEngine_SetCrosspoint(napi_env env, napi_callback_info info) { 
-    napi_value undefined = nullptr;
-    napi_get_undefined(env, &undefined);
-    return undefined;
+// Typed fast path: numbers in, engine setters called directly, no juce::var
+// round trip. A null or empty cueId addresses the master mixer, whose level
+// changes are posted and coalesced into one route rebuild per event tick.
+napi_value AudioEngine_SetCrosspoint(napi_env env, napi_callback_info info)
+{
+    FastArgs<5> args(env, info);
+    juce::String cueId;
+    int32_t input = 0, output = 0;
+    double level = 0.0;
+    bool muted = false;
+    
+    if (!args.engine() || !args.cueId(0, cueId) || !args.integer(1, input) || !args.integer(2, output)
+        || !args.number(3, level) || !args.optionalBoolean(4, muted)) {
+        return nullptr;
+    }
+    
+    return makeBoolean(env, args.engine()->postCrosspoint(cueId, input, output, static_cast<float>(level), muted));
 }
 
-napi_value AudioEngine_GetCrosspoint(napi_env env, napi_callback_info info) { 
-    napi_value undefined = nullptr;
-    napi_get_undefined(env, &undefined);
-    return undefined;
+napi_value AudioEngine_GetCrosspoint(napi_env env, napi_callback_info info)
+{
+    FastArgs<3> args(env, info);
+    juce::String cueId;
+    int32_t input = 0, output = 0;
+    
+    if (!args.engine() || !args.cueId(0, cueId) || !args.integer(1, input) || !args.integer(2, output)) {
+        return nullptr;
+    }
+    
+    return makeNumber(env, args.engine()->getCrosspoint(cueId, input, output));
 }
 
-napi_value AudioEngine_SetInputLevel(napi_env env, napi_callback_info info) { 
-    napi_value undefined = nullptr;
-    napi_get_undefined(env, &undefined);
-    return undefined;
+napi_value AudioEngine_SetInputLevel(napi_env env, napi_callback_info info)
+{
+    FastArgs<4> args(env, info);
+    juce::String cueId;
+    int32_t input = 0;
+    double level = 0.0;
+    bool muted = false;
+    
+    if (!args.engine() || !args.cueId(0, cueId) || !args.integer(1, input)
+        || !args.number(2, level) || !args.optionalBoolean(3, muted)) {
+        return nullptr;
+    }
+    
+    return makeBoolean(env, args.engine()->postInputLevel(cueId, input, static_cast<float>(level), muted));
 }
 
-napi_value AudioEngine_SetOutputLevel(napi_env env, napi_callback_info info) { 
-    napi_value undefined = nullptr;
-    napi_get_undefined(env, &undefined);
-    return undefined;
+napi_value AudioEngine_SetOutputLevel(napi_env env, napi_callback_info info)
+{
+    FastArgs<2> args(env, info);
+    int32_t output = 0;
+    double level = 0.0;
+    
+    if (!args.engine() || !args.integer(0, output) || !args.number(1, level)) {
+        return nullptr;
+    }
+    
+    return makeBoolean(env, args.engine()->postOutputLevel(output, static_cast<float>(level)));
 }
 
-napi_value AudioEngine_MuteOutput(napi_env env, napi_callback_info info) { 
-    napi_value undefined = nullptr;
-    napi_get_undefined(env, &undefined);
-    return undefined;
+napi_value AudioEngine_MuteOutput(napi_env env, napi_callback_info info)
+{
+    FastArgs<2> args(env, info);
+    int32_t output = 0;
+    bool mute = false;
+    
+    if (!args.engine() || !args.integer(0, output) || !args.boolean(1, mute)) {
+        return nullptr;
+    }
+    
+    return makeBoolean(env, args.engine()->muteOutput(output, mute));
 }
 
-napi_value AudioEngine_SoloOutput(napi_env env, napi_callback_info info) { 
-    napi_value undefined = nullptr;
-    napi_get_undefined(env, &undefined);
-    return undefined;
+napi_value AudioEngine_SoloOutput(napi_env env, napi_callback_info info)
+{
+    FastArgs<2> args(env, info);
+    int32_t output = 0;
+    bool solo = false;
+    
+    if (!args.engine() || !args.integer(0, output) || !args.boolean(1, solo)) {
+        return nullptr;
+    }
+    
+    return makeBoolean(env, args.engine()->soloOutput(output, solo));
 }
 
-napi_value AudioEngine_SetPatchRouting(napi_env env, napi_callback_info info) { 
-    napi_value undefined = nullptr;
-    napi_get_undefined(env, &undefined);
-    return undefined;
+napi_value AudioEngine_SetMatrix(napi_env env, napi_callback_info info)
+{
+    // setMatrix(cueId, levels: Float32Array (input-major), numOutputs)
+    FastArgs<3> args(env, info);
+    juce::String cueId;
+    const float* levels = nullptr;
+    size_t numLevels = 0;
+    int32_t numOutputs = 0;
+    
+    if (!args.engine() || !args.cueId(0, cueId) || !args.floatArray(1, levels, numLevels)
+        || !args.integer(2, numOutputs)) {
+        return nullptr;
+    }
+    
+    if (numOutputs <= 0) {
+        napi_throw_range_error(env, nullptr, "numOutputs must be positive");
+        return nullptr;
+    }
+    
+    if (numLevels % static_cast<size_t>(numOutputs) != 0) {
+        napi_throw_range_error(env, nullptr, "levels length must be a multiple of numOutputs");
+        return nullptr;
+    }
+    
+    const int numInputs = static_cast<int>(numLevels / static_cast<size_t>(numOutputs));
+    return makeBoolean(env, args.engine()->setMatrix(cueId, levels, numInputs, numOutputs));
 }
 
-napi_value AudioEngine_GetPatchRouting(napi_env env, napi_callback_info info) { 
-    napi_value undefined = nullptr;
-    napi_get_undefined(env, &undefined);
-    return undefined;
+napi_value AudioEngine_SetPatchRouting(napi_env env, napi_callback_info info)
+{
+    FastArgs<3> args(env, info);
+    int32_t cueOutput = 0, deviceOutput = 0;
+    double level = 0.0;
+    
+    if (!args.engine() || !args.integer(0, cueOutput) || !args.integer(1, deviceOutput) || !args.number(2, level)) {
+        return nullptr;
+    }
+    
+    return makeBoolean(env, args.engine()->setPatchRouting(cueOutput, deviceOutput, static_cast<float>(level)));
+}
+
+napi_value AudioEngine_GetPatchRouting(napi_env env, napi_callback_info info)
+{
+    FastArgs<2> args(env, info);
+    int32_t cueOutput = 0, deviceOutput = 0;
+    
+    if (!args.engine() || !args.integer(0, cueOutput) || !args.integer(1, deviceOutput)) {
+        return nullptr;
+    }
+    
+    return makeNumber(env, args.engine()->getPatchRouting(cueOutput, deviceOutput));
+}
+
+napi_value AudioEngine_SetPatchFusion(napi_env env, napi_callback_info info)
+{
+    FastArgs<1> args(env, info);
+    bool enabled = true;
+    
+    if (!args.engine() || !args.boolean(0, enabled)) {
+        return nullptr;
+    }
+    
+    args.engine()->setPatchFusion(enabled);
+    return makeBoolean(env, args.engine()->isPatchFused());
 }
 
 NAPI_MODULE(NODE_GYP_MODULE_NAME, Init)
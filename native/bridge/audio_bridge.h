@@ -8,9 +8,11 @@
 #include <juce_data_structures/juce_data_structures.h>
 
 #include <memory>
+#include <vector>
 
 class AudioEngine;
 class CommandProcessor;
+class TelemetryPublisher;
 
 /**
  * @brief N-API bridge between Node.js and JUCE audio engine
@@ -29,13 +31,24 @@ public:
     void shutdown();
     bool isInitialized() const;
     
+    // Direct engine access for the typed fast-path exports
+    AudioEngine* getEngine() const { return audioEngine.get(); }
+    
     // Command processing
     napi_value processCommand(napi_env env, const char* jsonCommand);
     napi_value processCommandVar(napi_env env, napi_value commandObj);
     
-    // Event system
+    // Event system: engine events reach the callback on the JS thread as
+    // callback(eventType, data), batched through a threadsafe function
+    static constexpr int MAX_PENDING_EVENTS = 256;
     void setEventCallback(napi_env env, napi_value callback);
     
+    // Shared telemetry: an ArrayBuffer the engine keeps filled with meters,
+    // playheads and the clock (layout in TelemetryPublisher.h)
+    napi_value createTelemetryBuffer(napi_env env, int maxCues);
+    napi_value getTelemetryCueIds(napi_env env);
+    void releaseTelemetryBuffer();
+    
     // Utility functions for N-API conversion
     static napi_value juceVarToNapi(napi_env env, const juce::var& value);
     static juce::var napiToJuceVar(napi_env env, napi_value value);
@@ -46,13 +59,31 @@ private:
     std::unique_ptr<AudioEngine> audioEngine;
     std::unique_ptr<CommandProcessor> commandProcessor;
     
-    // Event callback storage
-    napi_env eventEnv;
-    napi_ref eventCallbackRef;
+    // Events waiting for the JS thread. Bounded: when full the oldest is
+    // dropped and counted. A newer event with the same type and cueId
+    // replaces the pending one, so bursts collapse to their latest state.
+    // Only one threadsafe call is outstanding at a time; it drains the batch.
+    struct PendingEvent {
+        juce::String type;
+        juce::var data;
+    };
+    juce::CriticalSection pendingEventLock;
+    std::vector<PendingEvent> pendingEvents;
+    std::vector<PendingEvent> deliveringEvents;
+    int droppedEvents;
+    bool drainScheduled;
+    napi_threadsafe_function eventFunction;
+    
+    // Telemetry writer and the reference that keeps its ArrayBuffer alive
+    std::unique_ptr<TelemetryPublisher> telemetryPublisher;
+    napi_env telemetryEnv;
+    napi_ref telemetryBufferRef;
     
     // Event handling
     void onAudioEvent(const juce::String& eventType, const juce::var& eventData);
-    void callJavaScriptCallback(const juce::String& eventType, const juce::var& eventData);
+    void releaseEventFunction();
+    void deliverPendingEvents(napi_env env, napi_value callback);
+    static void callJavaScriptCallback(napi_env env, napi_value callback, void* context, void* data);
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioBridge)
 };
@@ -69,6 +100,8 @@ extern "C" {
     napi_value AudioEngine_GetStatus(napi_env env, napi_callback_info info);
     napi_value AudioEngine_ProcessCommand(napi_env env, napi_callback_info info);
     napi_value AudioEngine_SetEventCallback(napi_env env, napi_callback_info info);
+    napi_value AudioEngine_GetTelemetryBuffer(napi_env env, napi_callback_info info);
+    napi_value AudioEngine_GetTelemetryCueIds(napi_env env, napi_callback_info info);
     
     // Device management
     napi_value AudioEngine_SetAudioDevice(napi_env env, napi_callback_info info);
@@ -90,10 +123,12 @@ extern "C" {
     napi_value AudioEngine_SetOutputLevel(napi_env env, napi_callback_info info);
     napi_value AudioEngine_MuteOutput(napi_env env, napi_callback_info info);
     napi_value AudioEngine_SoloOutput(napi_env env, napi_callback_info info);
+    napi_value AudioEngine_SetMatrix(napi_env env, napi_callback_info info);
     
     // Output patch control
     napi_value AudioEngine_SetPatchRouting(napi_env env, napi_callback_info info);
     napi_value AudioEngine_GetPatchRouting(napi_env env, napi_callback_info info);
+    napi_value AudioEngine_SetPatchFusion(napi_env env, napi_callback_info info);
     
     // Helper macros for N-API error handling
     #define NAPI_CALL(env, call)                                      \
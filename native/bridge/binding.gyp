@@ -7,6 +7,19 @@
         "../src/AudioCue.cpp", 
         "../src/MatrixMixer.cpp",
         "../src/OutputPatch.cpp",
+        "../src/DiskStreamer.cpp",
+        "../src/SampleCache.cpp",
+        "../src/TransportQueue.cpp",
+        "../src/CueSequencer.cpp",
+        "../src/FadeEngine.cpp",
+        "../src/CueMatrix.cpp",
+        "../src/RenderPool.cpp",
+        "../src/MixKernel.cpp",
+        "../src/MeterBank.cpp",
+        "../src/TelemetryPublisher.cpp",
+        "../src/VirtualAudioDevice.cpp",
+        "../src/LatencyHistogram.cpp",
+        "../src/TraceRecorder.cpp",
         "../src/CommandProcessor.cpp",
         "audio_bridge.cpp"
       ],
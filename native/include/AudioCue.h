@@ -6,42 +6,97 @@
 #include <juce_audio_formats/juce_audio_formats.h>
 #include <juce_audio_utils/juce_audio_utils.h>
 
+#include "SampleCache.h"
+#include "FadeEngine.h"
+#include "CueMatrix.h"
+
 #include <memory>
 #include <atomic>
 
 class MatrixMixer;
+class DiskStream;
+class DiskStreamer;
 
 /**
  * @brief Audio cue class for file playback with matrix integration
  * 
  * Handles audio file loading, playback control, and routing to matrix mixer.
  * Supports multiple audio formats and provides sample-accurate timing.
+ * Audio data is streamed from disk through a DiskStream that is kept full
+ * by the engine's DiskStreamer, so the audio thread never reads the file.
+ * Short cues can instead be preloaded fully into RAM and played with no
+ * disk I/O at all; the engine decides which cues stay resident. Resident
+ * audio lives in the engine's SampleCache, so cues that play the same file
+ * share a single decoded copy.
+ * Each cue sums onto the engine bus through its own CueMatrix.
  */
 class AudioCue
 {
 public:
-    AudioCue(const juce::String& id, MatrixMixer* mixer);
+    AudioCue(const juce::String& id, MatrixMixer* mixer,
+             juce::AudioFormatManager* formatManager, DiskStreamer* streamer,
+             SampleCache* sampleCache);
     ~AudioCue();
 
+    // Device configuration (called while the cue is idle)
+    void prepareToPlay(double outputSampleRate, int maximumBlockSize);
+
     // File management
     bool loadFile(const juce::String& filePath);
     void unloadFile();
     bool isLoaded() const { return fileLoaded.load(); }
 
+    // RAM preload (control thread; the engine owns the memory budget)
+    SampleCache::SharedBuffer findSharedAudio() const;
+    SampleCache::SharedBuffer decodeIntoMemory() const;
+    void setPreloadedAudio(SampleCache::SharedBuffer audio);
+    bool releasePreload();
+    bool isPreloaded() const { return preloadedAudio != nullptr; }
+    SampleCache::SharedBuffer getPreloadedAudio() const { return preloadedAudio; }
+    size_t getPreloadedBytes() const;
+    size_t estimatePreloadBytes() const;
+
+    // Control thread: positions an idle streaming cue at startTime so the disk
+    // worker has the ring filled before the play command reaches the audio
+    // thread. Skipped while an earlier command for the cue is still queued,
+    // since the audio thread may be about to start it from the old position
+    void cueStream(double startTime);
+    
+    // Transport commands for this cue queued but not yet applied: the control
+    // thread counts them in, whoever drains the queue counts them out
+    void transportQueued() { transportInFlight.fetch_add(1); }
+    void transportApplied() { transportInFlight.fetch_sub(1); }
+    
     // Playback control
-    bool play(double startTime = 0.0, double fadeInTime = 0.0);
-    bool stop(double fadeOutTime = 0.0);
+    bool play(double startTime = 0.0, double fadeInTime = 0.0, juce::int64 startSample = -1,
+              FadeCurve fadeCurve = FadeCurve::linear);
+    bool stop(double fadeOutTime = 0.0, FadeCurve fadeCurve = FadeCurve::linear);
     bool pause();
     bool resume();
     
     // State queries
     bool isPlaying() const { return playing.load(); }
     bool isPaused() const { return paused.load(); }
+    bool isScheduled() const { return scheduledStartSample.load() >= 0; }
+    bool hasReachedEnd() const { return reachedEnd.load(); }
+    bool isStreamReady(int numSamples) const;  // Offline rendering waits on this
+    int getNumUnderruns() const;               // Blocks the disk stream couldn't supply
     double getCurrentTime() const;
     double getDuration() const;
     
-    // Audio processing (called from audio thread)
-    void processAudioBlock(juce::AudioBuffer<float>& buffer, int numSamples);
+    // Audio processing (called from audio thread); blockStartSample is the
+    // engine clock position of the first sample in the block
+    void processAudioBlock(juce::AudioBuffer<float>& buffer, int numSamples,
+                           juce::int64 blockStartSample);
+    
+    // Audio thread, once per block after rendering: what changed since the
+    // previous call, however the cue was started or stopped
+    enum VoiceChange
+    {
+        voiceEnded = 1,     // Stopped playing: played out, stopped, or fade-out done
+        fadeFinished = 2    // Fade-in reached full level while still playing
+    };
+    int takeVoiceChanges();
     
     // Properties
     const juce::String& getId() const { return cueId; }
@@ -49,18 +104,26 @@ public:
     int getNumChannels() const;
     double getSampleRate() const;
 
-    // Matrix integration
-    bool setInputChannel(int fileChannel, int matrixInput);
-    int getInputChannel(int fileChannel) const;
+    // Matrix integration (file channels -> bus / MatrixMixer inputs)
+    CueMatrix& getMatrix() { return matrix; }
+    const CueMatrix& getMatrix() const { return matrix; }
 
 private:
     const juce::String cueId;
     MatrixMixer* matrixMixer;
+    juce::AudioFormatManager* formatManager;
+    DiskStreamer* diskStreamer;
+    SampleCache* sampleCache;
+    
+    // Audio file data; only opened for cues that stream (null while the cue
+    // plays shared RAM audio it has never had to stream)
+    std::unique_ptr<DiskStream> diskStream;
+    bool openDiskStream(std::unique_ptr<juce::AudioFormatReader> reader);
     
-    // Audio file data
-    std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
-    std::unique_ptr<juce::AudioTransportSource> transportSource;
-    std::unique_ptr<juce::ResamplingAudioSource> resamplingSource;
+    // RAM-resident audio at the output sample rate (preload mode, shared)
+    SampleCache::SharedBuffer preloadedAudio;
+    std::atomic<bool> playingFromMemory{false};
+    std::atomic<juce::int64> memoryPosition{0};
     
     // File information
     juce::File audioFile;
@@ -69,30 +132,37 @@ private:
     std::atomic<double> sampleRate{0.0};
     std::atomic<double> lengthInSeconds{0.0};
     
+    // Device configuration
+    std::atomic<double> outputSampleRate{44100.0};
+    int maxBlockSize = 512;
+    
     // Playback state
     std::atomic<bool> playing{false};
     std::atomic<bool> paused{false};
     std::atomic<bool> stopRequested{false};
+    std::atomic<juce::int64> scheduledStartSample{-1};
+    std::atomic<bool> reachedEnd{false};
+    std::atomic<bool> awaitingStream{false};  // Start held until the ring has its first block
+    std::atomic<int> transportInFlight{0};
+    
+    // Per-sample fade (audio thread; transport commands are applied there)
+    FadeEngine fade;
     
-    // Fade control
-    struct FadeState {
-        std::atomic<bool> active{false};
-        std::atomic<float> currentLevel{1.0f};
-        std::atomic<float> targetLevel{1.0f};
-        std::atomic<float> stepSize{0.0f};
-        std::atomic<int> remainingSamples{0};
-    } fadeState;
+    // State at the last takeVoiceChanges() (audio thread)
+    bool reportedPlaying = false;
+    bool reportedFading = false;
     
-    // Channel routing (file channel -> matrix input)
-    std::vector<int> channelRouting;
+    // Per-cue routing (file channel -> matrix input)
+    CueMatrix matrix;
     
     // Processing buffers
     juce::AudioBuffer<float> processingBuffer;
     
     // Internal methods
-    void initializeSources();
-    void updateFade(int numSamples);
-    void applyFadeToBuffer(juce::AudioBuffer<float>& buffer, int numSamples);
+    void rewind();
+    void seekTo(double seconds);
+    int readFromMemory(juce::AudioBuffer<float>& destination, int numSamples);
+    bool isSourceFinished() const;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioCue)
 };
\ No newline at end of file
@@ -11,8 +11,18 @@
 
 #include "MatrixMixer.h"
 #include "OutputPatch.h"
+#include "DiskStreamer.h"
+#include "SampleCache.h"
+#include "TransportQueue.h"
+#include "CueSequencer.h"
+#include "RenderPool.h"
+#include "LatencyHistogram.h"
+#include "VirtualAudioDevice.h"
+#include <functional>
 #include <memory>
 #include <atomic>
+#include <array>
+#include <list>
 
 /**
  * @brief Main audio engine class implementing JUCE AudioIODeviceCallback
@@ -23,11 +33,23 @@
 class AudioEngine : public juce::AudioIODeviceCallback
 {
 public:
+    using EventCallback = std::function<void(const juce::String& event, const juce::var& data)>;
+    
     AudioEngine();
     ~AudioEngine() override;
 
     // Core engine control
-    bool initialize();
+    // Channel counts are fixed when the device opens: numDeviceOutputs is
+    // what we ask the device for (the patch follows what it actually gives),
+    // numBuses is the cue bus / mixer input count
+    static constexpr int DEFAULT_DEVICE_OUTPUTS = 2;
+    bool initialize(int numDeviceOutputs = DEFAULT_DEVICE_OUTPUTS,
+                    int numBuses = MatrixMixer::DEFAULT_INPUTS,
+                    int numMixerOutputs = MatrixMixer::DEFAULT_OUTPUTS);
+    // Same, but on the built-in virtual device (no hardware needed)
+    bool initializeVirtual(const VirtualAudioDevice::Settings& settings,
+                           int numBuses = MatrixMixer::DEFAULT_INPUTS,
+                           int numMixerOutputs = MatrixMixer::DEFAULT_OUTPUTS);
     void shutdown();
     bool isInitialized() const { return initialized.load(); }
 
@@ -36,23 +58,103 @@ public:
     juce::StringArray getAvailableDevices() const;
     juce::String getCurrentDevice() const;
     
-    // Performance monitoring
+    // Performance monitoring: load is callback time as a percentage of the
+    // block's duration; a dropout is a callback that overran its block or
+    // arrived too late for the device to have had audio to play
+    static constexpr double LOAD_AVERAGE_SECONDS = 0.5;
+    static constexpr double LOAD_WINDOW_SECONDS = 1.0;
+    static constexpr double LATE_CALLBACK_PERIODS = 1.0;
+    
+    // Host clock mapping: block time stamps go through a delay-locked loop
+    // of this bandwidth; an error of more than CLOCK_RELOCK_PERIODS blocks
+    // (a glitch or clock jump) re-locks it, and a device time stamp further
+    // than HOST_TIME_TOLERANCE_MS from the millisecond counter is not trusted
+    static constexpr double CLOCK_BANDWIDTH_HZ = 0.5;
+    static constexpr double CLOCK_RELOCK_PERIODS = 4.0;
+    static constexpr double HOST_TIME_TOLERANCE_MS = 1000.0;
+    
     struct Status {
         bool isRunning;
         double sampleRate;
         int bufferSize;
-        double cpuUsage;
+        double cpuUsage;          // Exponentially averaged load, percent
+        double peakCpuUsage;      // Worst block in the last full window, percent
+        double lastCallbackMs;
         int dropoutCount;
+        int overrunCount;
+        int lateCallbackCount;
+        int diskUnderruns;        // Across the loaded cues' disk streams
+        int numDiskStreams;
         juce::String currentDevice;
+        juce::int64 preloadBudgetBytes;
+        juce::int64 preloadedBytes;
+        int numPreloadedCues;
+        int numSharedSamples;
+        juce::int64 sharedSampleBytes;  // Decoded audio held by the sample cache
+        int renderThreads;
+        bool patchFusionEnabled;
+        bool busMetering;
+        bool patchFused;
+        juce::String mixKernel;
+        int numBuses;
+        int numMixerOutputs;
+        int numDeviceOutputs;
+        bool offlineRendering;
+        double offlineRenderedSeconds;
     };
     Status getStatus() const;
+    
+    // Where the callback's time goes: the whole callback plus each stage of it,
+    // recorded every block. When the patch is fused into the mixer its routing
+    // time counts as mixer time and outputPatch only covers device metering.
+    enum class TimingStage {
+        callback,     // Whole callback
+        transport,    // Queued transport commands and sequencer triggers
+        cueRender,    // Decoding, resampling and fades, including the worker join
+        mixer,        // MatrixMixer
+        outputPatch   // OutputPatch and device output meters
+    };
+    static constexpr int NUM_TIMING_STAGES = 5;
+    static const char* getTimingStageName(TimingStage stage);
+    const LatencyHistogram& getTimingHistogram(TimingStage stage) const;
+    void resetTimingHistograms();
+    
+    // Peak/RMS/peak-hold for every bus (mixer input), mixer output and device output.
+    // Mixer outputs only exist as buffers on the two-stage path, so they read
+    // silence while the patch is fused unless bus metering is switched on
+    struct Meters {
+        std::vector<MeterBank::Level> inputs;
+        std::vector<MeterBank::Level> outputs;
+        std::vector<MeterBank::Level> deviceOutputs;
+    };
+    Meters getMeters() const;
+    void getMeters(Meters& meters) const;  // refills meters without reallocating
+    
+    // Playhead of every cue, in cue id order, for displays that poll
+    struct Playhead {
+        juce::String cueId;
+        double currentTime = 0.0;
+        double duration = 0.0;
+        bool playing = false;
+        bool paused = false;
+        bool scheduled = false;
+    };
+    void getPlayheads(std::vector<Playhead>& playheads) const;
+    double getSampleRate() const { return currentSampleRate.load(); }
 
     // AudioIODeviceCallback implementation
     void audioDeviceIOCallback(const float* const* inputChannelData,
                              int numInputChannels,
                              float* const* outputChannelData,
                              int numOutputChannels,
-                             int numSamples);
+                             int numSamples,
+                             const std::uint64_t* hostTimeNs = nullptr);
+    void audioDeviceIOCallbackWithContext(const float* const* inputChannelData,
+                                          int numInputChannels,
+                                          float* const* outputChannelData,
+                                          int numOutputChannels,
+                                          int numSamples,
+                                          const juce::AudioIODeviceCallbackContext& context) override;
 
     void audioDeviceAboutToStart(juce::AudioIODevice* device) override;
     void audioDeviceStopped() override;
@@ -60,56 +162,341 @@ public:
     // Audio cue management
     bool createAudioCue(const juce::String& cueId, const juce::String& filePath);
     bool loadAudioFile(const juce::String& cueId, const juce::String& filePath);
-    bool playCue(const juce::String& cueId, double startTime = 0.0, double fadeInTime = 0.0);
-    bool stopCue(const juce::String& cueId, double fadeOutTime = 0.0);
+    bool playCue(const juce::String& cueId, double startTime = 0.0, double fadeInTime = 0.0,
+                 FadeCurve fadeCurve = FadeCurve::linear);
+    bool stopCue(const juce::String& cueId, double fadeOutTime = 0.0,
+                 FadeCurve fadeCurve = FadeCurve::linear);
     bool pauseCue(const juce::String& cueId);
     bool resumeCue(const juce::String& cueId);
     void stopAllCues();
+    bool isCueLoaded(const juce::String& cueId) const;
+    
+    // Sample-accurate scheduling against the engine clock, which counts
+    // output samples since the engine was created
+    bool playCueAtSample(const juce::String& cueId, juce::int64 samplePosition,
+                         double startTime = 0.0, double fadeInTime = 0.0,
+                         FadeCurve fadeCurve = FadeCurve::linear);
+    bool playCueAtHostTime(const juce::String& cueId, double hostTimeMs,
+                           double startTime = 0.0, double fadeInTime = 0.0,
+                           FadeCurve fadeCurve = FadeCurve::linear);
+    juce::int64 getSamplePosition() const { return samplePosition.load(); }
+    juce::int64 hostTimeToSamplePosition(double hostTimeMs) const;
+    
+    // Transactions (control thread, not nestable): transport commands and
+    // matrix changes made in between reach the audio thread together on one
+    // block boundary, or are all dropped by abortTransaction(), which also
+    // puts the master matrix back as it was at beginTransaction()
+    void beginTransaction();
+    void commitTransaction();
+    void abortTransaction();
+    
+    // Cue sequencing on the audio clock (waits in seconds)
+    bool setCueTiming(const juce::String& cueId, const CueSequencer::CueTiming& timing);
+    bool goCue(const juce::String& cueId, juce::int64 samplePosition = -1);
+    
+    // Parallel voice rendering: extra real-time threads that render cues
+    // alongside the device thread (0 = render everything on the device thread)
+    static constexpr int MIN_PARALLEL_VOICES = 4;
+    bool setRenderThreads(int numThreads);
+    int getRenderThreads() const { return numRenderThreads.load(); }
+    
+    // Offline rendering: with no device open, pulls blocks as fast as the CPU
+    // allows and writes the device outputs to outputFile (WAV, FLAC or AIFF by
+    // extension). Runs on its own thread and ends with an offlineRenderComplete
+    // or offlineRenderFailed event. Transport and cue commands work as usual
+    // while it runs, and disk streams are waited for rather than underrun.
+    static constexpr double MAX_OFFLINE_RENDER_SECONDS = 6.0 * 60.0 * 60.0;
+    struct OfflineRenderSettings {
+        juce::File outputFile;
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        int bitDepth = 24;
+        double durationSeconds = 0.0;   // 0 = until every cue and follow-on has finished
+        double tailSeconds = 0.0;       // Keep rendering this long after that (fade and ramp tails)
+        int renderThreads = -1;         // Extra voice threads; -1 = one per spare core
+        juce::String goCueId;           // Optional cue to GO when rendering starts
+    };
+    bool startOfflineRender(const OfflineRenderSettings& settings);
+    void cancelOfflineRender();
+    bool isOfflineRendering() const { return offlineRenderer != nullptr && offlineRenderer->isThreadRunning(); }
+    
+    // Engine events (cueStarted, cueCompleted, fadeCompleted, audioDropout), delivered on a background thread
+    void setEventCallback(EventCallback callback);
+
+    // RAM preload (short cues served from memory, long cues keep streaming)
+    static constexpr size_t DEFAULT_PRELOAD_BUDGET_BYTES = 512 * 1024 * 1024;
+    bool setCuePreload(const juce::String& cueId, bool preload);
+    void setPreloadBudget(size_t budgetBytes);
+    size_t getPreloadBudget() const { return preloadBudget.load(); }
+    size_t getPreloadedBytes() const { return preloadedBytes.load(); }
 
-    // Matrix routing control
-    bool setCrosspoint(const juce::String& cueId, int input, int output, float level);
+    // Matrix routing control. With a cueId these address that cue's own
+    // CueMatrix (file channel -> bus); an empty cueId addresses the master mixer
+    bool setCrosspoint(const juce::String& cueId, int input, int output, float level, bool muted = false);
     float getCrosspoint(const juce::String& cueId, int input, int output) const;
-    bool setInputLevel(const juce::String& cueId, int input, float level);
+    bool setInputLevel(const juce::String& cueId, int input, float level, bool muted = false);
+    bool setCueOutputLevel(const juce::String& cueId, int output, float level, bool muted = false);
+    bool setCueMatrix(const juce::String& cueId, const std::vector<std::vector<float>>& levels);
+    bool setMatrix(const juce::String& cueId, const float* levels, int numInputs, int numOutputs);
     bool setOutputLevel(int output, float level);
     bool muteOutput(int output, bool mute);
     bool soloOutput(int output, bool solo);
+    bool setGainRampTime(float seconds);
+    
+    // Fader-rate variants for the typed bridge path: master mixer changes are
+    // stored lock-free and published together by the event thread within one
+    // tick; cue matrix changes are atomic stores either way
+    bool postCrosspoint(const juce::String& cueId, int input, int output, float level, bool muted = false);
+    bool postInputLevel(const juce::String& cueId, int input, float level, bool muted = false);
+    bool postOutputLevel(int output, float level);
 
     // Output patch routing
     bool setPatchRouting(int cueOutput, int deviceOutput, float level);
     float getPatchRouting(int cueOutput, int deviceOutput) const;
+    
+    // Run mixer and patch as one fused matrix (default) or as two stages.
+    // Bus metering needs the mixer outputs, so it keeps the engine two-stage.
+    // Switching either way snaps the mixer's gains (ramps in flight are dropped)
+    void setPatchFusion(bool enabled);
+    bool isPatchFusionEnabled() const { return patchFusionEnabled.load(); }
+    void setBusMetering(bool enabled);
+    bool isBusMeteringEnabled() const { return busMeteringEnabled.load(); }
+    bool isPatchFused() const { return mixer->isPatchFused(); }
 
 private:
     // Audio format management
     std::unique_ptr<juce::AudioFormatManager> formatManager;
     std::unique_ptr<juce::AudioDeviceManager> deviceManager;
+    VirtualAudioDeviceType* virtualDeviceType = nullptr; // Owned by deviceManager once added
     
     // Core audio components
     std::unique_ptr<MatrixMixer> mixer;
     std::unique_ptr<OutputPatch> outputPatch;
+    std::atomic<bool> patchFusionEnabled{true};
+    std::atomic<bool> busMeteringEnabled{false};
+    
+    // Background disk reading for streaming cues (must outlive the cues)
+    std::unique_ptr<DiskStreamer> diskStreamer;
     
-    // Audio cue storage
+    // Decoded audio shared by every cue that plays the same file (must outlive the cues)
+    std::unique_ptr<SampleCache> sampleCache;
+    
+    // Audio cue storage (control threads only, guarded by cueMapLock)
     std::map<juce::String, std::unique_ptr<class AudioCue>> audioCues;
     
-    // Thread safety
+    // Immutable cue list read by the audio thread without locking. A new
+    // snapshot is published whenever the cue set changes; the audio thread
+    // announces the snapshot it is walking so old ones are only freed once
+    // it has moved on.
+    struct CueSnapshot {
+        std::vector<class AudioCue*> cues;
+        std::unique_ptr<CueSequencer::Graph> sequence;
+        RenderPool* renderPool = nullptr;
+    };
+    std::unique_ptr<CueSnapshot> currentSnapshot;
+    std::vector<std::unique_ptr<CueSnapshot>> retiredSnapshots;
+    std::atomic<CueSnapshot*> publishedSnapshot{nullptr};
+    std::atomic<CueSnapshot*> audioThreadSnapshot{nullptr};
+    
+    // Transport changes travel to the audio thread through this queue while
+    // the device runs; otherwise they are applied directly under cueMapLock
+    std::unique_ptr<TransportQueue> transportQueue;
+    std::atomic<bool> deviceRunning{false};
+    
+    // The audio thread only applies commands up to transportReleased; an
+    // open transaction stops releasing until it commits (counts guarded by
+    // cueMapLock, except transportApplied which belongs to the audio side)
+    bool transportHeld = false;
+    juce::int64 transportQueued = 0;
+    std::atomic<juce::int64> transportReleased{0};
+    juce::int64 transportApplied = 0;
+    
+    // An aborted transaction's commands are already in the queue, so they are
+    // released with the range [skipFrom, skipTo) marked for the consumer to
+    // drop; abortTransaction() waits for them to go before returning
+    std::atomic<juce::int64> transportSkipFrom{0};
+    std::atomic<juce::int64> transportSkipTo{0};
+    
+    // stopAllCues() while the device runs: a flag rather than a queue slot,
+    // applied once the consumer reaches command panicThrough
+    std::atomic<bool> panicRequested{false};
+    std::atomic<juce::int64> panicThrough{0};
+    
+    // State an open transaction can still take back (cueMapLock): where its
+    // commands start in the queue, commands held while the device is stopped,
+    // and the master matrix as it was when the transaction began
+    juce::int64 transactionStart = 0;
+    std::vector<TransportCommand> heldTransport;
+    MatrixMixer::Controls transactionControls;
+    
+    // Per-cue matrix writes made inside a transaction. They are staged on the
+    // control side and handed over at commit, and the audio thread applies them
+    // on the block that reaches releaseAt, together with the held transport.
+    struct CueMatrixChange
+    {
+        enum class Type { crosspoint, inputLevel, outputLevel };
+        
+        Type type = Type::crosspoint;
+        class AudioCue* cue = nullptr;
+        int channel = 0;
+        int output = 0;
+        float level = 0.0f;
+        bool muted = false;
+    };
+    struct CueMatrixChanges
+    {
+        std::vector<CueMatrixChange> changes;
+        juce::int64 releaseAt = 0;
+        juce::int64 sequence = 0;
+    };
+    std::unique_ptr<CueMatrixChanges> stagedCueChanges;              // Open transaction's writes
+    std::vector<std::unique_ptr<CueMatrixChanges>> sentCueChanges;   // Freed once applied
+    std::atomic<CueMatrixChanges*> pendingCueChanges{nullptr};
+    std::atomic<juce::int64> appliedCueChanges{0};
+    juce::int64 nextCueChangeSequence = 0;
+    
+    // Engine sample clock and its mapping to juce::Time::getMillisecondCounterHiRes()
+    std::atomic<juce::int64> samplePosition{0};
+    std::atomic<double> clockOriginMs{0.0};
+    
+    // Follow-on timing, run by the audio thread
+    std::unique_ptr<CueSequencer> cueSequencer;
+    
+    // Forwards sequencer events to the event callback off the audio thread
+    class EventThread : public juce::Thread
+    {
+    public:
+        explicit EventThread(AudioEngine& owner);
+        ~EventThread() override;
+        
+        void run() override;
+        
+    private:
+        AudioEngine& engine;
+    };
+    
+    juce::CriticalSection eventLock;
+    EventCallback eventCallback;
+    std::unique_ptr<EventThread> eventThread;
+    
+    // Drives the audio callback in place of a device for offline renders
+    class OfflineRenderThread : public juce::Thread
+    {
+    public:
+        OfflineRenderThread(AudioEngine& owner, const OfflineRenderSettings& settings);
+        ~OfflineRenderThread() override;
+        
+        void run() override;
+        double getRenderedSeconds() const { return renderedSeconds.load(); }
+        
+    private:
+        AudioEngine& engine;
+        const OfflineRenderSettings settings;
+        std::atomic<double> renderedSeconds{0.0};
+        
+        juce::String render();
+        bool waitForStreams(int numSamples);
+        bool isFinished();
+    };
+    
+    std::unique_ptr<OfflineRenderThread> offlineRenderer;
+    
+    // RAM preload bookkeeping (most recently used first, guarded by cueMapLock);
+    // shared buffers are only counted once against the budget
+    std::list<juce::String> preloadLru;
+    std::atomic<size_t> preloadBudget{DEFAULT_PRELOAD_BUDGET_BYTES};
+    std::atomic<size_t> preloadedBytes{0};
+    std::atomic<int> numPreloadedCues{0};
+    
+    // Thread safety (never taken on the audio thread)
     juce::CriticalSection cueMapLock;
-    juce::SpinLock audioLock; // For real-time audio thread
     
     // Performance monitoring
     std::atomic<bool> initialized{false};
     std::atomic<double> currentSampleRate{44100.0};
     std::atomic<int> currentBufferSize{512};
+    std::atomic<int> numBusChannels{MatrixMixer::DEFAULT_INPUTS};
+    std::atomic<int> numMixerOutputChannels{MatrixMixer::DEFAULT_OUTPUTS};
     std::atomic<double> cpuUsage{0.0};
+    std::atomic<double> peakCpuUsage{0.0};
+    std::atomic<double> lastCallbackMs{0.0};
     std::atomic<int> dropoutCount{0};
+    std::atomic<int> overrunCount{0};
+    std::atomic<int> lateCallbackCount{0};
+    int reportedDropouts = 0; // Event thread only
+    
+    // Audio thread callback timing, reset by prepareToRender()
+    struct CallbackTiming {
+        bool realtime = true;         // Offline renders have no deadline
+        juce::int64 expectedTicks = 0; // When the next callback is due, 0 before the first
+        double windowSeconds = 0.0;
+        double windowPeak = 0.0;
+    } callbackTiming;
+    
+    // Audio thread clock loop, reset by prepareToRender()
+    struct ClockFilter {
+        bool locked = false;
+        double nextBlockMs = 0.0;  // Predicted host time of the next block's first sample
+        double msPerSample = 0.0;  // Device rate as measured against the host clock
+    } clockFilter;
+    
+    std::array<LatencyHistogram, NUM_TIMING_STAGES> timingHistograms;
     
     // Audio processing
     juce::AudioBuffer<float> mixBuffer;
     juce::AudioBuffer<float> tempBuffer;
     
+    // Parallel rendering: one matrix-input bus per extra worker, summed into
+    // mixBuffer after the join (worker 0 renders straight into mixBuffer)
+    std::unique_ptr<RenderPool> renderPool;
+    std::atomic<int> numRenderThreads{0};
+    std::vector<juce::AudioBuffer<float>> workerBuses;
+    std::vector<juce::uint8> workerBusUsed;
+    
+    struct RenderContext {
+        const CueSnapshot* snapshot = nullptr;
+        int numSamples = 0;
+        juce::int64 blockStart = 0;
+    } renderContext;
+    
     // Internal methods
     void initializeAudioFormats();
+    void configureChannels(int numBuses, int numMixerOutputs, int numDeviceOutputs);
     void setupAudioDevice();
-    void processAudioBlock(float* const* outputChannelData, int numOutputChannels, int numSamples);
-    void updatePerformanceMetrics();
+    bool startDevice(int numBuses, int numMixerOutputs, int requestedOutputs);
+    void prepareToRender(double sampleRate, int blockSize, bool realtime);
+    void stopRendering();
+    void applyQueuedTransport();
+    void postEvent(const juce::String& name, const juce::var& data);
+    void processAudioBlock(const CueSnapshot* snapshot, float* const* outputChannelData,
+                           int numOutputChannels, int numSamples, juce::int64 stageStart);
+    void updatePerformanceMetrics(juce::int64 startTicks, int numSamples);
+    void updateClockMapping(juce::int64 blockStart, int numSamples, const std::uint64_t* hostTimeNs);
+    juce::int64 recordStageTime(TimingStage stage, juce::int64 startTicks);
+    CueSnapshot* acquireCueSnapshot();
+    bool dispatchTransport(const TransportCommand& command);
+    void applyTransportCommand(const TransportCommand& command, const CueSnapshot* snapshot);
+    bool isTransportSkipped(juce::int64 index) const;
+    void consumeTransport(juce::int64 released, const CueSnapshot* snapshot);
+    void drainTransport();
+    void writeCueMatrix(const CueMatrixChange& change);
+    void publishCueChanges();
+    void applyPendingCueChanges(juce::int64 released);
+    void reclaimCueChanges();
+    static void applyCueMatrixChange(const CueMatrixChange& change);
+    void publishCueSnapshot(const class AudioCue* excludedCue = nullptr);
+    void detachCue(const class AudioCue* cue);
+    void reclaimSnapshots();
+    void refreshPatchFusion();
+    void waitForAudioThread();
+    void prepareWorkerBuses(int blockSize);
+    static void renderVoice(void* context, int jobIndex, int workerIndex);
+    void reportVoiceChanges(const CueSnapshot* snapshot, juce::int64 blockEndSample);
+    void deliverEvents();
+    bool releaseCuePreload(class AudioCue* cue);
+    bool evictPreloadsFor(size_t requiredBytes);
+    void touchPreload(const juce::String& cueId);
+    void updatePreloadUsage();
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioEngine)
 };
\ No newline at end of file
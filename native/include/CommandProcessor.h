@@ -31,9 +31,11 @@ public:
     void setEventCallback(EventCallback callback);
     void sendEvent(const juce::String& eventType, const juce::var& eventData);
 
-    // Command registration
+    // Command registration; requiredParams lets a batch validate the command
+    // before any of it runs
     void registerCommand(const juce::String& commandName, 
-                        std::function<juce::var(const juce::var&)> handler);
+                        std::function<juce::var(const juce::var&)> handler,
+                        const juce::StringArray& requiredParams = {});
 
 private:
     AudioEngine* audioEngine;
@@ -41,13 +43,21 @@ private:
     
     // Command handlers map
     std::map<juce::String, std::function<juce::var(const juce::var&)>> commandHandlers;
+    std::map<juce::String, juce::StringArray> commandParameters;
     
     // Built-in command handlers
     juce::var handleInitialize(const juce::var& params);
     juce::var handleShutdown(const juce::var& params);
     juce::var handleGetStatus(const juce::var& params);
+    juce::var handleGetMeters(const juce::var& params);
+    juce::var handleGetTimingStats(const juce::var& params);
+    juce::var handleResetTimingStats(const juce::var& params);
+    juce::var handleStartTrace(const juce::var& params);
+    juce::var handleStopTrace(const juce::var& params);
+    juce::var handleWriteTrace(const juce::var& params);
     juce::var handleSetAudioDevice(const juce::var& params);
     juce::var handleGetDevices(const juce::var& params);
+    juce::var handleBatch(const juce::var& params);
     
     // Audio cue commands
     juce::var handleCreateCue(const juce::var& params);
@@ -57,24 +67,47 @@ private:
     juce::var handlePauseCue(const juce::var& params);
     juce::var handleResumeCue(const juce::var& params);
     juce::var handleStopAllCues(const juce::var& params);
+    juce::var handlePlayCueAt(const juce::var& params);
+    juce::var handleGetClock(const juce::var& params);
+    juce::var handleSetCueTiming(const juce::var& params);
+    juce::var handleGoCue(const juce::var& params);
+    juce::var handleSetCuePreload(const juce::var& params);
+    juce::var handleSetPreloadBudget(const juce::var& params);
+    juce::var handleSetRenderThreads(const juce::var& params);
+    juce::var handleRenderOffline(const juce::var& params);
+    juce::var handleCancelOfflineRender(const juce::var& params);
     
     // Matrix commands
     juce::var handleSetCrosspoint(const juce::var& params);
     juce::var handleGetCrosspoint(const juce::var& params);
     juce::var handleSetInputLevel(const juce::var& params);
+    juce::var handleSetCueOutputLevel(const juce::var& params);
+    juce::var handleSetCueMatrixRouting(const juce::var& params);
     juce::var handleSetOutputLevel(const juce::var& params);
     juce::var handleMuteOutput(const juce::var& params);
     juce::var handleSoloOutput(const juce::var& params);
+    juce::var handleSetGainRampTime(const juce::var& params);
     
     // Patch commands
     juce::var handleSetPatchRouting(const juce::var& params);
     juce::var handleGetPatchRouting(const juce::var& params);
+    juce::var handleSetPatchFusion(const juce::var& params);
+    juce::var handleSetBusMetering(const juce::var& params);
     
     // Utility methods
     void registerBuiltInCommands();
     juce::var createErrorResponse(const juce::String& message, int code = -1);
     juce::var createSuccessResponse(const juce::var& data = juce::var());
     bool validateParameters(const juce::var& params, const juce::StringArray& required);
+    // Engine channel counts that batch commands are checked against
+    struct BatchLimits
+    {
+        int numBuses = 0;
+        int numMixerOutputs = 0;
+    };
+    juce::String validateBatchCommand(const juce::var& command, const BatchLimits& limits) const;
+    juce::String validateBatchEffect(const juce::String& commandName, const juce::var& params,
+                                     const BatchLimits& limits) const;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CommandProcessor)
 };
\ No newline at end of file
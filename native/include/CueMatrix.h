@@ -0,0 +1,82 @@
+#pragma once
+
+// Individual JUCE module includes
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+/**
+ * @brief Per-cue level matrix from file channels to cue outputs
+ *
+ * Each AudioCue owns one of these and applies it while summing its audio
+ * onto the engine bus (the MatrixMixer inputs), so every cue has its own
+ * routing, input levels and output levels. Controls are atomics written by
+ * the control thread. A bit mask per file channel marks the outputs it
+ * feeds, so the audio thread only touches live crosspoints. Gain changes
+ * ramp across one block. The output count follows the engine's bus count.
+ */
+class CueMatrix
+{
+public:
+    static constexpr int MAX_CHANNELS = 32;
+    static constexpr int DEFAULT_OUTPUTS = 64;
+    static constexpr float MAX_GAIN_DB = 12.0f;
+
+    explicit CueMatrix(int numOutputs = DEFAULT_OUTPUTS);
+
+    // Resizes the output side, keeping the overlapping settings. Only while
+    // the audio thread cannot be processing this cue
+    void configure(int numOutputs);
+    int getNumOutputs() const { return numOutputChannels; }
+
+    // Crosspoints (file channel -> cue output)
+    void setCrosspoint(int channel, int output, float level, bool muted = false);
+    float getCrosspoint(int channel, int output) const;
+    bool isCrosspointMuted(int channel, int output) const;
+
+    // File channel (input) and cue output levels
+    void setInputLevel(int channel, float level, bool muted = false);
+    float getInputLevel(int channel) const;
+    void setOutputLevel(int output, float level, bool muted = false);
+    float getOutputLevel(int output) const;
+
+    // Channel n to output n at unity, everything else silent
+    void setDefaultRouting();
+    void clearAllCrosspoints();
+
+    // Audio thread: destination[output] += source[channel] * gain for every
+    // live crosspoint of the first numChannels channels
+    void process(const juce::AudioBuffer<float>& source, int numChannels,
+                 juce::AudioBuffer<float>& destination, int destinationStart, int numSamples);
+
+private:
+    static constexpr int MASK_BITS = 64;
+
+    int numOutputChannels = 0;
+    int numMaskWords = 0;
+
+    int levelIndex(int channel, int output) const { return channel * numOutputChannels + output; }
+    int maskIndex(int channel, int output) const { return channel * numMaskWords + output / MASK_BITS; }
+    static juce::uint64 maskBit(int output) { return juce::uint64(1) << (output % MASK_BITS); }
+
+    // Levels are channel-major; each channel owns numMaskWords route/mute words
+    std::vector<std::atomic<float>> levels;
+    std::vector<std::atomic<juce::uint64>> routeMasks;
+    std::vector<std::atomic<juce::uint64>> mutedMasks;
+
+    std::array<std::atomic<float>, MAX_CHANNELS> inputLevels;
+    std::atomic<juce::uint64> inputMutes{0};
+    std::vector<std::atomic<float>> outputLevels;
+    std::vector<std::atomic<juce::uint64>> outputMutes;
+
+    // Audio thread: gains applied last block, so changes ramp rather than step
+    std::vector<float> appliedGains;
+    std::vector<juce::uint64> appliedMasks;
+
+    static float clampLevel(float level);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CueMatrix)
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+// Individual JUCE module includes
+#include <juce_core/juce_core.h>
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class AudioCue;
+
+/**
+ * @brief Something that happened to a cue on the audio thread, reported to the UI
+ */
+struct SequencerEvent
+{
+    enum class Type
+    {
+        cueStarted,
+        cueCompleted,
+        fadeCompleted
+    };
+
+    Type type = Type::cueStarted;
+    AudioCue* cue = nullptr;
+    juce::int64 samplePosition = 0;
+};
+
+/**
+ * @brief Runs cue-list timing (pre-wait, post-wait, auto-continue, auto-follow)
+ *        on the engine's sample clock
+ *
+ * The control thread edits per-cue timing and compiles it into an immutable
+ * Graph that AudioEngine publishes alongside its cue snapshot. The audio
+ * thread calls process() once per block before the cues render: it fires
+ * every trigger that falls inside the block at its exact sample, so chains
+ * of follow-ons stay sample accurate however busy the UI is. Starts are
+ * reported through a wait-free event FIFO, which the engine also uses to
+ * report every voice that ends or finishes fading in, sequenced or not.
+ */
+class CueSequencer
+{
+public:
+    enum class ContinueMode
+    {
+        doNotContinue,
+        autoContinue,   // GO the next cue postWait after this one starts
+        autoFollow      // GO the next cue when this one plays to its end
+    };
+
+    struct CueTiming
+    {
+        double preWait = 0.0;   // Seconds from GO to the cue starting
+        double postWait = 0.0;  // Seconds from start to auto-continue
+        ContinueMode continueMode = ContinueMode::doNotContinue;
+        juce::String nextCueId;
+    };
+
+    // Compiled, read-only form of the timing graph for the audio thread
+    struct Graph
+    {
+        struct Node
+        {
+            AudioCue* cue = nullptr;
+            double preWait = 0.0;
+            double postWait = 0.0;
+            ContinueMode continueMode = ContinueMode::doNotContinue;
+            AudioCue* next = nullptr;
+        };
+
+        std::unordered_map<const AudioCue*, Node> nodes;
+        const Node* find(const AudioCue* cue) const;
+    };
+
+    static constexpr int MAX_PENDING_TRIGGERS = 256;
+    static constexpr int MAX_RUNNING_CUES = 256;
+    static constexpr int EVENT_QUEUE_SIZE = 1024;
+
+    CueSequencer();
+    ~CueSequencer();
+
+    // Timing graph (control thread, serialised by AudioEngine::cueMapLock)
+    void setCueTiming(const juce::String& cueId, const CueTiming& timing);
+    bool getCueTiming(const juce::String& cueId, CueTiming& timing) const;
+    std::unique_ptr<Graph> buildGraph(const std::map<juce::String, std::unique_ptr<AudioCue>>& cues,
+                                      const AudioCue* excludedCue) const;
+
+    // Audio thread
+    bool go(AudioCue* cue, juce::int64 goSample);
+    void clear();
+    void process(const Graph* graph, juce::int64 blockStartSample, int numSamples, double sampleRate);
+    void checkCompletions(const Graph* graph, juce::int64 blockEndSample);
+    bool isIdle() const { return pendingTriggers.empty() && runningCues.empty(); }
+    void pushEvent(SequencerEvent::Type type, AudioCue* cue, juce::int64 samplePosition);
+
+    // Event delivery (any single consumer thread)
+    bool popEvent(SequencerEvent& event);
+
+private:
+    enum class TriggerType
+    {
+        start,  // Pre-wait elapsed: start the cue
+        go      // Auto-continue: GO the cue (runs its pre-wait)
+    };
+
+    struct Trigger
+    {
+        TriggerType type = TriggerType::go;
+        AudioCue* cue = nullptr;
+        juce::int64 fireSample = 0;
+    };
+
+    std::map<juce::String, CueTiming> timings;
+
+    // Audio thread state (fixed capacity, no allocation while running)
+    std::vector<Trigger> pendingTriggers;
+    std::vector<AudioCue*> runningCues;
+
+    // Audio thread -> control side events
+    juce::AbstractFifo eventFifo{EVENT_QUEUE_SIZE};
+    std::vector<SequencerEvent> events;
+
+    bool addTrigger(TriggerType type, AudioCue* cue, juce::int64 fireSample);
+    void fireTrigger(const Graph& graph, const Trigger& trigger, double sampleRate);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CueSequencer)
+};
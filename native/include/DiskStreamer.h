@@ -0,0 +1,127 @@
+#pragma once
+
+// Individual JUCE module includes
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+
+#include <memory>
+#include <atomic>
+#include <vector>
+
+/**
+ * @brief Read-ahead ring buffer between a disk I/O thread and the audio thread
+ *
+ * One DiskStream exists per streaming cue. A DiskStreamer worker (producer)
+ * decodes the file ahead of the play position into the ring, converting to the
+ * device sample rate on the way, while the audio thread (consumer) copies out
+ * of it. Positions are absolute output-rate sample positions, so the ring is
+ * wait-free in both directions and the audio callback never touches the file.
+ */
+class DiskStream
+{
+public:
+    static constexpr double DEFAULT_READ_AHEAD_SECONDS = 1.5;
+    static constexpr int READ_CHUNK_SAMPLES = 8192;
+
+    DiskStream(std::unique_ptr<juce::AudioFormatReader> reader,
+               double readAheadSeconds = DEFAULT_READ_AHEAD_SECONDS);
+    ~DiskStream();
+
+    // Consumer side (audio thread, or any thread while the cue is idle)
+    void prepare(double outputSampleRate);
+    int read(juce::AudioBuffer<float>& destination, int numSamples);
+    void seek(juce::int64 outputPosition);
+    juce::int64 getPosition() const { return readPosition.load(std::memory_order_acquire); }
+    bool isFinished() const;
+    bool isReadyFor(int numSamples) const;
+    int getNumUnderruns() const { return underrunCount.load(); }
+
+    // Producer side (DiskStreamer worker thread)
+    bool service();
+
+    // File properties
+    int getNumChannels() const { return numChannels; }
+    double getSourceSampleRate() const { return sourceSampleRate; }
+    juce::int64 getOutputLength() const { return outputLength.load(); }
+
+private:
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    const int numChannels;
+    const double sourceSampleRate;
+    const juce::int64 sourceLength;
+    const double readAheadSeconds;
+
+    // Ring storage (output-rate samples)
+    juce::AudioBuffer<float> ring;
+    int capacity = 0;
+
+    // Shared positions - the consumer owns readPosition and seekGeneration,
+    // the producer owns writePosition and filledGeneration
+    std::atomic<juce::int64> readPosition{0};
+    std::atomic<juce::int64> writePosition{0};
+    std::atomic<juce::uint32> seekGeneration{0};
+    std::atomic<juce::uint32> filledGeneration{0};
+    std::atomic<double> resampleRatio{1.0};
+    std::atomic<juce::int64> outputLength{0};
+    std::atomic<int> underrunCount{0};
+    
+    // seek() may also run on the control thread to cue an idle stream ahead of
+    // a play; held only for a few atomic operations
+    juce::SpinLock seekLock;
+
+    // Producer state
+    juce::int64 sourcePosition = 0;
+    double producerRatio = 1.0;
+    std::vector<juce::LagrangeInterpolator> interpolators;
+    juce::AudioBuffer<float> sourceBuffer;
+    juce::AudioBuffer<float> chunkBuffer;
+
+    int readChunk(int numSamples);
+    void writeToRing(juce::int64 outputPosition, const juce::AudioBuffer<float>& source, int numSamples);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DiskStream)
+};
+
+/**
+ * @brief Pool of disk I/O threads that keep every registered DiskStream full
+ *
+ * Streams are spread across the workers so that many long stems can be read
+ * from one drive in parallel. Each worker repeatedly tops up the streams it
+ * owns and sleeps briefly when there is nothing to read.
+ */
+class DiskStreamer
+{
+public:
+    static constexpr int DEFAULT_NUM_THREADS = 2;
+    static constexpr int IDLE_WAIT_MS = 5;
+
+    explicit DiskStreamer(int numThreads = DEFAULT_NUM_THREADS);
+    ~DiskStreamer();
+
+    // Stream registration (control thread)
+    void addStream(DiskStream* stream);
+    void removeStream(DiskStream* stream);
+    void wakeUp();
+
+    int getNumThreads() const { return static_cast<int>(workers.size()); }
+    int getNumStreams() const;
+
+private:
+    class Worker : public juce::Thread
+    {
+    public:
+        explicit Worker(int index);
+        ~Worker() override;
+
+        void run() override;
+        bool serviceStreams();
+
+        juce::CriticalSection streamLock;
+        std::vector<DiskStream*> streams;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DiskStreamer)
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+// Individual JUCE module includes
+#include <juce_core/juce_core.h>
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+/**
+ * @brief Log-linear histogram of durations for one writer thread
+ *
+ * HDR-style bucketing: durations are recorded in nanoseconds, every power of
+ * two is split into SUB_BUCKETS linear buckets, so any value is kept to within
+ * 1 / SUB_BUCKETS (about 6%) across the whole range up to MAX_NANOSECONDS.
+ * The audio thread records with a few relaxed stores and never waits; readers
+ * on other threads take a consistent-enough copy of the counts at any time.
+ *
+ * reset() doesn't touch the counters the writer owns. It snapshots them as a
+ * baseline that later summaries subtract, so it is safe from any thread while
+ * the audio thread keeps recording.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAX_MAGNITUDE = 36; // 2^36 ns, about 68 seconds
+    static constexpr int NUM_BUCKETS = SUB_BUCKETS * (MAX_MAGNITUDE - SUB_BUCKET_BITS + 1);
+    static constexpr juce::int64 MAX_NANOSECONDS = (juce::int64(1) << MAX_MAGNITUDE) - 1;
+
+    struct Summary
+    {
+        juce::int64 count = 0;
+        double meanUs = 0.0;
+        double minUs = 0.0;
+        double p50Us = 0.0;
+        double p90Us = 0.0;
+        double p99Us = 0.0;
+        double p999Us = 0.0;
+        double maxUs = 0.0;
+    };
+
+    LatencyHistogram() = default;
+
+    // Audio thread (one writer)
+    void record(juce::int64 nanoseconds) noexcept;
+
+    // Any thread; everything is counted from the last reset()
+    Summary getSummary() const;
+    void getCounts(std::vector<juce::uint64>& counts) const;
+    void reset();
+
+    // Bucket bounds in nanoseconds, for plotting getCounts()
+    static juce::int64 getBucketLowerBound(int bucket);
+    static juce::int64 getBucketUpperBound(int bucket);
+
+private:
+    static int getBucketIndex(juce::int64 nanoseconds) noexcept;
+    void copyCounts(std::vector<juce::uint64>& counts, juce::uint64& totalNanoseconds) const;
+
+    std::array<std::atomic<juce::uint64>, NUM_BUCKETS> buckets {};
+    std::atomic<juce::uint64> sumNanoseconds{0};
+
+    // Reader side baseline taken by reset()
+    juce::CriticalSection baselineLock;
+    std::vector<juce::uint64> baseline = std::vector<juce::uint64>(NUM_BUCKETS, 0);
+    juce::uint64 baselineSum = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LatencyHistogram)
+};
@@ -5,37 +5,100 @@
 #include <juce_data_structures/juce_data_structures.h>
 #include <juce_audio_basics/juce_audio_basics.h>
 
+#include "MeterBank.h"
+#include "MixKernel.h"
+#include "OutputPatch.h"
+
 #include <array>
 #include <atomic>
+#include <memory>
+#include <vector>
 
 /**
  * @brief Professional matrix mixer with atomic operations for real-time safety
  * 
- * Implements a 64x64 crosspoint matrix with individual level controls,
+ * Implements an inputs x outputs crosspoint matrix (64x64 by default, sized
+ * at device-open time with configure()) with individual level controls,
  * input/output level controls, and mute/solo functionality.
  * All operations are lock-free for use in real-time audio contexts.
+ *
+ * Control changes are compiled on the calling thread into a sparse route
+ * list (one entry per audible crosspoint, with input level, output level,
+ * mute and solo folded into a single gain) that is swapped in atomically.
+ * The audio thread only walks that list, so mixing cost follows the number
+ * of active routes rather than the size of the matrix.
+ *
+ * Gain changes never jump: when a route's gain changes (including mute,
+ * solo and removal) the audio thread ramps linearly from the gain it is
+ * currently applying to the new one over the configured ramp time.
+ *
+ * When the output patch is fused in (setFusedPatch), the compiled list holds
+ * the product of both matrices - input straight to device output - and the
+ * mixer writes the device buffers directly, skipping the intermediate
+ * buses. clearFusedPatch() returns to the two-stage path for callers that
+ * need those buses.
+ *
+ * Every input and output is metered in the same callback, right after it
+ * is mixed. While the patch is fused the output buses are never formed, so
+ * their meters read silence; the engine keeps the patch unfused while bus
+ * metering is switched on.
  */
 class MatrixMixer
 {
 public:
-    static constexpr int MAX_INPUTS = 64;
-    static constexpr int MAX_OUTPUTS = 64;
+    static constexpr int DEFAULT_INPUTS = 64;
+    static constexpr int DEFAULT_OUTPUTS = 64;
+    static constexpr int MAX_CHANNELS = 512;
     
-    MatrixMixer();
+    MatrixMixer(int numInputs = DEFAULT_INPUTS, int numOutputs = DEFAULT_OUTPUTS);
     ~MatrixMixer();
 
-    // Core mixing operation (real-time safe)
-    void processAudioBlock(const float* const* inputBuffers, 
+    // Resizes the matrix, keeping the overlapping settings. Only while the
+    // audio thread is not running; maxFusedOutputs bounds the device side
+    // of a fused patch
+    void configure(int numInputs, int numOutputs, int maxFusedOutputs);
+    int getNumInputs() const { return numInputChannels; }
+    int getNumOutputs() const { return numOutputChannels; }
+
+    // Called before the audio thread starts (sizes the ramp scratch buffers)
+    void prepare(double sampleRate, int maxBlockSize);
+
+    // Core mixing operation (real-time safe). Mixes into outputBuffers, or
+    // into fusedBuffers when the patch is fused in; returns true in that case
+    bool processAudioBlock(const float* const* inputBuffers, 
                           float* const* outputBuffers,
                           int numInputs, 
                           int numOutputs, 
-                          int numSamples);
+                          int numSamples,
+                          float* const* fusedBuffers = nullptr,
+                          int numFusedOutputs = 0);
+
+    // Output patch fusion (control thread)
+    void setFusedPatch(std::vector<OutputPatch::Route> patchRoutes);
+    void clearFusedPatch();
+    bool isPatchFused() const { return patchFused.load(); }
 
     // Crosspoint control
     void setCrosspoint(int input, int output, float level);
     float getCrosspoint(int input, int output) const;
     void clearCrosspoint(int input, int output);
     void clearAllCrosspoints();
+    
+    // Whole matrix in one route rebuild: levels is input-major with
+    // numOutputs columns; crosspoints it does not cover are cleared
+    void setCrosspoints(const float* levels, int numInputs, int numOutputs);
+    
+    // Route changes made between these are published in one rebuild (nestable)
+    void beginUpdate();
+    void endUpdate();
+    
+    // High-rate control (fader moves): lock-free and allocation-free, the
+    // value is stored and the rebuild left to the next commitPostedChanges(),
+    // so any number of posts between two commits cost one rebuild
+    void postCrosspoint(int input, int output, float level);
+    void postInputLevel(int input, float level, bool mute);
+    void postOutputLevel(int output, float level);
+    bool commitPostedChanges();
 
     // Input controls
     void setInputLevel(int input, float level);
@@ -51,6 +114,15 @@ public:
     void soloOutput(int output, bool solo);
     bool isOutputSoloed(int output) const;
 
+    // Metering (readable from any thread)
+    const MeterBank& getInputMeters() const { return inputMeters; }
+    const MeterBank& getOutputMeters() const { return outputMeters; }
+
+    // Gain smoothing (seconds to reach a new gain; 0 = apply on the next block)
+    static constexpr float DEFAULT_RAMP_TIME = 0.01f;
+    void setRampTime(float seconds);
+    float getRampTime() const { return rampTime.load(); }
+
     // Gang operations
     void setInputGang(const std::vector<int>& inputs, float level);
     void setOutputGang(const std::vector<int>& outputs, float level);
@@ -59,6 +131,20 @@ public:
     void saveState(juce::ValueTree& state) const;
     void loadState(const juce::ValueTree& state);
     void resetToDefault();
+    
+    // Every level, mute and solo, for putting the matrix back exactly as it
+    // was (control thread; reuses the vectors' storage)
+    struct Controls
+    {
+        std::vector<float> crosspoints;
+        std::vector<float> inputLevels;
+        std::vector<float> outputLevels;
+        std::vector<bool> inputMutes;
+        std::vector<bool> outputMutes;
+        std::vector<bool> outputSolos;
+    };
+    void captureControls(Controls& controls) const;
+    void restoreControls(const Controls& controls);
 
     // Utility functions
     static float dBToLinear(float dB);
@@ -68,22 +154,115 @@ public:
     static constexpr float MIN_GAIN_DB = -60.0f;
 
 private:
-    // Matrix storage (atomic for real-time safety)
-    std::array<std::array<std::atomic<float>, MAX_OUTPUTS>, MAX_INPUTS> crosspoints;
+    // Channel counts, changed only by configure()
+    int numInputChannels = 0;
+    int numOutputChannels = 0;
+    int maxFusedOutputChannels = 0;
+    
+    // Matrix storage (atomic for real-time safety), input-major so one
+    // input's crosspoints are contiguous for the route compiler
+    std::vector<std::atomic<float>> crosspoints;
+    int crosspointIndex(int input, int output) const { return input * numOutputChannels + output; }
     
     // Input controls
-    std::array<std::atomic<float>, MAX_INPUTS> inputLevels;
-    std::array<std::atomic<bool>, MAX_INPUTS> inputMutes;
+    std::vector<std::atomic<float>> inputLevels;
+    std::vector<std::atomic<bool>> inputMutes;
     
     // Output controls
-    std::array<std::atomic<float>, MAX_OUTPUTS> outputLevels;
-    std::array<std::atomic<bool>, MAX_OUTPUTS> outputMutes;
-    std::array<std::atomic<bool>, MAX_OUTPUTS> outputSolos;
+    std::vector<std::atomic<float>> outputLevels;
+    std::vector<std::atomic<bool>> outputMutes;
+    std::vector<std::atomic<bool>> outputSolos;
     
     // Solo state management
     std::atomic<bool> hasSoloActive{false};
     void updateSoloState();
     
+    // Compiled routes, ordered by input so each input feeds its outputs in one run
+    struct Route
+    {
+        int input;
+        int output;
+        float gain;
+    };
+    
+    struct RouteList
+    {
+        std::vector<Route> routes;
+        bool fused = false;         // Route outputs are device outputs
+        juce::uint64 sequence = 0;  // Increases with every rebuild, never reused
+    };
+    
+    // Built under routeLock and published like the engine's cue snapshot:
+    // the audio thread announces the list it is walking in audioThreadRoutes
+    // and retired lists are freed once it has moved on
+    juce::CriticalSection routeLock;
+    int updateDepth = 0;
+    bool routesPending = false;
+    std::atomic<bool> routesPosted{false};
+    juce::uint64 nextRouteSequence = 0;
+    std::vector<OutputPatch::Route> fusedPatch;  // Sorted by cueOutput
+    std::vector<int> fusedPatchStart;            // fusedPatch[start[o], start[o + 1]) feed from output o
+    std::atomic<bool> patchFused{false};
+    
+    // Rebuild scratch, sized by configure() so control changes don't allocate it
+    std::vector<Route> scratchBusRoutes;
+    std::vector<float> scratchOutputLevels;
+    std::vector<float> scratchDeviceGains;
+    std::vector<int> scratchDevices;
+    std::unique_ptr<RouteList> currentRoutes;
+    std::vector<std::unique_ptr<RouteList>> retiredRoutes;
+    std::atomic<RouteList*> publishedRoutes{nullptr};
+    std::atomic<RouteList*> audioThreadRoutes{nullptr};
+    
+    void rebuildRoutes();
+    void bucketFusedPatch();
+    void reclaimRoutes();
+    const RouteList* acquireRoutes();
+    
+    // Audio-thread gain state. routeGains holds the gain currently applied
+    // to every crosspoint; activeRoutes lists the ones that are non-zero or
+    // still ramping, including routes that left the list and are fading out.
+    // A route's slot is input * routeStride + output, wide enough for both
+    // mixer outputs and fused device outputs
+    int routeStride = 0;
+    size_t routeSlot(int input, int output) const { return static_cast<size_t>(input * routeStride + output); }
+    
+    struct ActiveRoute
+    {
+        int input;
+        int output;
+        float target;
+        float step;
+        int remaining;
+    };
+    
+    std::vector<ActiveRoute> activeRoutes;
+    std::vector<ActiveRoute> nextActiveRoutes;
+    std::vector<MixKernel::Group> steadyGroups;
+    std::vector<MixKernel::Tap> steadyTaps;
+    std::vector<float> routeGains;
+    std::vector<juce::uint32> routeStamps;
+    juce::uint32 routeGeneration = 0;
+    // Compared by sequence, not address: a retired list's memory can be
+    // reused for a newer one
+    juce::uint64 lastRouteSequence = 0;
+    bool lastRoutesFused = false;
+    
+    std::atomic<float> rampTime{DEFAULT_RAMP_TIME};
+    std::atomic<double> currentSampleRate{44100.0};
+    juce::HeapBlock<float> rampIndex;
+    juce::HeapBlock<float> rampGains;
+    int rampCapacity = 0;
+    
+    void syncActiveRoutes(const RouteList& list);
+    void retarget(ActiveRoute& route, float target, int rampSamples);
+    void addRamped(float* dest, const float* source, float startGain, float step, int numSamples);
+    
+    // Meters, measured on the audio thread after mixing
+    MeterBank inputMeters;
+    MeterBank outputMeters;
+    bool outputMetersCleared = false;
+    
     // Performance optimization
     juce::AudioBuffer<float> tempBuffer;
     
@@ -0,0 +1,59 @@
+#pragma once
+
+// Individual JUCE module includes
+#include <juce_core/juce_core.h>
+
+#include <atomic>
+#include <vector>
+
+/**
+ * @brief Peak, RMS and peak-hold meters for a set of channels
+ *
+ * The audio thread measures each block right after it has been mixed, while
+ * the samples are still in cache, and publishes the results as per-channel
+ * atomics. Any thread can read them at any time without locking; a reader
+ * sees each value from the latest block, never a torn one. Peaks fall back
+ * at PEAK_DECAY_DB_PER_SECOND, RMS is averaged over RMS_WINDOW_SECONDS and
+ * the hold value sticks for PEAK_HOLD_SECONDS.
+ */
+class MeterBank
+{
+public:
+    struct Level
+    {
+        float peak = 0.0f;
+        float rms = 0.0f;
+        float peakHold = 0.0f;
+    };
+
+    static constexpr float PEAK_DECAY_DB_PER_SECOND = 20.0f;
+    static constexpr float RMS_WINDOW_SECONDS = 0.3f;
+    static constexpr float PEAK_HOLD_SECONDS = 2.0f;
+
+    MeterBank() = default;
+
+    // Control thread, while the audio thread is not measuring
+    void configure(int numChannels);
+    void prepare(double sampleRate);
+
+    // Audio thread
+    void process(const float* const* channels, int numChannels, int numSamples);
+    void clear();
+
+    // Any thread
+    int getNumChannels() const { return static_cast<int>(peaks.size()); }
+    Level getLevel(int channel) const;
+    void getLevels(std::vector<Level>& levels) const;
+
+private:
+    std::vector<std::atomic<float>> peaks;
+    std::vector<std::atomic<float>> rmsLevels;
+    std::vector<std::atomic<float>> holds;
+
+    // Audio thread ballistics state
+    std::vector<float> meanSquares;
+    std::vector<int> holdSamplesLeft;
+    double sampleRate = 44100.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MeterBank)
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+// Individual JUCE module includes
+#include <juce_core/juce_core.h>
+
+/**
+ * @brief Multi-output accumulate kernel used by MatrixMixer
+ *
+ * Mixes a set of sources into their destinations in short tiles of samples:
+ * within a tile every source is loaded once per group of up to four
+ * destinations instead of once per crosspoint, and the destination tiles
+ * stay in L1 across all the sources that feed them. The inner loop is
+ * picked once at startup from AVX2, SSE2, NEON or plain C++.
+ */
+namespace MixKernel
+{
+    // Samples per tile: 64 outputs x 64 floats is 16 KB of destination data
+    static constexpr int TILE_SAMPLES = 64;
+
+    struct Tap
+    {
+        int output;
+        float gain;
+    };
+
+    // A source and the run of taps in the tap array that it feeds
+    struct Group
+    {
+        const float* source;
+        int firstTap;
+        int numTaps;
+    };
+
+    // outputs[tap.output][i] += group.source[i] * tap.gain for every tap
+    void process(const Group* groups, int numGroups, const Tap* taps,
+                 float* const* outputs, int numSamples);
+
+    // Name of the selected inner loop ("avx2", "sse2", "neon" or "scalar")
+    const char* getImplementationName();
+}
@@ -5,25 +5,37 @@
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_data_structures/juce_data_structures.h>
 
+#include "MeterBank.h"
+
 #include <array>
 #include <atomic>
+#include <vector>
 
 /**
  * @brief Output patch matrix for routing mixer outputs to device outputs
  * 
- * Second-stage routing matrix that takes the 64 outputs from MatrixMixer
- * and routes them to physical device outputs. Supports flexible routing
- * configurations for different hardware setups.
+ * Second-stage routing matrix that takes the MatrixMixer outputs and routes
+ * them to physical device outputs. Supports flexible routing configurations
+ * for different hardware setups; both sides are sized at device-open time.
+ * Device outputs are metered as they leave the patch, so the meters show
+ * exactly what is sent to the hardware.
  */
 class OutputPatch
 {
 public:
-    static constexpr int MAX_CUE_OUTPUTS = 64;
-    static constexpr int MAX_DEVICE_OUTPUTS = 32;
+    static constexpr int DEFAULT_CUE_OUTPUTS = 64;
+    static constexpr int DEFAULT_DEVICE_OUTPUTS = 32;
+    static constexpr int MAX_CHANNELS = 512;
     
-    OutputPatch();
+    OutputPatch(int numCueOutputs = DEFAULT_CUE_OUTPUTS, int numDeviceOutputs = DEFAULT_DEVICE_OUTPUTS);
     ~OutputPatch();
 
+    // Resizes the patch, keeping the overlapping settings (audio thread stopped)
+    void configure(int numCueOutputs, int numDeviceOutputs);
+    int getNumCueOutputs() const { return numCueChannels; }
+    int getNumDeviceOutputs() const { return numDeviceChannels; }
+    void prepare(double sampleRate);
+
     // Core processing (real-time safe)
     void processAudioBlock(const float* const* cueOutputs,
                           float* const* deviceOutputs,
@@ -31,6 +43,21 @@ public:
                           int numDeviceOutputs,
                           int numSamples);
 
+    // Audible routes with device level and mute folded in, for fusing the
+    // patch into MatrixMixer's route list (control thread)
+    struct Route
+    {
+        int cueOutput;
+        int deviceOutput;
+        float gain;
+    };
+    std::vector<Route> compileRoutes() const;
+
+    // Device output metering. processAudioBlock meters its own result;
+    // callers that bypass it (fused mixing) meter the device buffers here
+    void meterDeviceOutputs(const float* const* deviceOutputs, int numDeviceOutputs, int numSamples);
+    const MeterBank& getDeviceMeters() const { return deviceMeters; }
+
     // Patch routing control
     void setPatchRouting(int cueOutput, int deviceOutput, float level);
     float getPatchRouting(int cueOutput, int deviceOutput) const;
@@ -58,12 +85,20 @@ public:
     static float linearToDb(float linear);
     
 private:
-    // Patch matrix (cue output -> device output)
-    std::array<std::array<std::atomic<float>, MAX_DEVICE_OUTPUTS>, MAX_CUE_OUTPUTS> patchMatrix;
+    // Channel counts, changed only by configure()
+    int numCueChannels = 0;
+    int numDeviceChannels = 0;
+    
+    // Patch matrix (cue output -> device output), cue-output-major
+    std::vector<std::atomic<float>> patchMatrix;
+    int patchIndex(int cueOutput, int deviceOutput) const { return cueOutput * numDeviceChannels + deviceOutput; }
     
     // Device output controls
-    std::array<std::atomic<float>, MAX_DEVICE_OUTPUTS> deviceOutputLevels;
-    std::array<std::atomic<bool>, MAX_DEVICE_OUTPUTS> deviceOutputMutes;
+    std::vector<std::atomic<float>> deviceOutputLevels;
+    std::vector<std::atomic<bool>> deviceOutputMutes;
+    
+    // Device output meters (audio thread writes, anyone reads)
+    MeterBank deviceMeters;
     
     // Processing optimization
     juce::AudioBuffer<float> tempBuffer;
@@ -0,0 +1,87 @@
+#pragma once
+
+// Individual JUCE module includes
+#include <juce_core/juce_core.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Real-time worker pool that renders voices in parallel
+ *
+ * The audio thread hands a block's jobs to run(), which splits them into one
+ * work-stealing range per worker (the calling thread is worker 0). Each
+ * worker pops jobs from the back of its own range and, once that is empty,
+ * steals from the front of the others, so uneven voices (a resampling stem
+ * next to a short preloaded sting) still balance across cores. run() returns
+ * only when every job has finished. Nothing allocates once the pool is
+ * constructed.
+ *
+ * Between blocks a worker spins briefly, then naps in short lock-free sleeps
+ * for ACTIVE_WINDOW_MS, so steady playback never has to wake it. After that
+ * it parks on its event with no timeout. run() signals only workers that
+ * flagged themselves as parked, so the audio thread touches an event (and
+ * its lock) only on the first parallel block after an idle spell.
+ */
+class RenderPool
+{
+public:
+    using JobFunction = void (*)(void* context, int jobIndex, int workerIndex);
+
+    static constexpr int MAX_WORKERS = 16;
+    static constexpr int SPIN_ITERATIONS = 64;
+    static constexpr int NAP_MICROSECONDS = 100;
+    static constexpr int ACTIVE_WINDOW_MS = 50;
+
+    explicit RenderPool(int numWorkerThreads);
+    ~RenderPool();
+
+    // Workers including the calling thread
+    int getNumWorkers() const { return numWorkers; }
+
+    // Audio thread: renders jobs [0, numJobs) and waits for all of them
+    void run(int numJobs, JobFunction function, void* context);
+
+private:
+    // A range of job indices; the owner pops from the bottom, thieves take the top
+    struct alignas(64) JobRange
+    {
+        std::atomic<int> top{0};
+        std::atomic<int> bottom{0};
+    };
+
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker(RenderPool& owner, int index);
+        ~Worker() override;
+
+        void run() override;
+
+        juce::WaitableEvent wakeUp;
+        std::atomic<bool> parked{false};  // Set before waiting on wakeUp
+
+    private:
+        RenderPool& pool;
+        const int workerIndex;
+    };
+
+    const int numWorkers;
+    std::unique_ptr<JobRange[]> ranges;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    // Current block
+    JobFunction jobFunction = nullptr;
+    void* jobContext = nullptr;
+    std::atomic<juce::uint32> generation{0};
+    std::atomic<bool> accepting{false};
+    std::atomic<int> remainingJobs{0};
+    std::atomic<int> busyWorkers{0};
+
+    void work(int workerIndex);
+    bool popOwn(int workerIndex, int& job);
+    bool steal(int victimIndex, int& job);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RenderPool)
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+// Individual JUCE module includes
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include <map>
+#include <memory>
+
+/**
+ * @brief Content-addressed store of decoded audio shared between cues
+ *
+ * Shows often contain many copies of the same cue with different fades and
+ * routing. Decoded audio is keyed by file path, modification time, size and
+ * the sample rate it was converted to, so every cue that references the same
+ * file shares one read-only buffer. Entries are reference counted through
+ * shared_ptr: the cache only holds weak references and a buffer is freed as
+ * soon as the last cue lets go of it.
+ */
+class SampleCache
+{
+public:
+    using SampleBuffer = juce::AudioBuffer<float>;
+    using SharedBuffer = std::shared_ptr<const SampleBuffer>;
+
+    struct Key
+    {
+        juce::String path;
+        juce::int64 modificationTime = 0;
+        juce::int64 fileSize = 0;
+        double sampleRate = 0.0;
+
+        bool operator<(const Key& other) const;
+        bool operator==(const Key& other) const;
+    };
+
+    SampleCache();
+    ~SampleCache();
+
+    static Key makeKey(const juce::File& file, double outputSampleRate);
+
+    // Lookup and registration (any non-audio thread)
+    SharedBuffer find(const Key& key);
+    SharedBuffer insert(const Key& key, SharedBuffer audio);
+    void purge();
+
+    // Statistics (live entries only)
+    int getNumEntries() const;
+    size_t getTotalBytes() const;
+    static size_t getBufferBytes(const SampleBuffer& audio);
+
+private:
+    mutable juce::CriticalSection lock;
+    std::map<Key, std::weak_ptr<const SampleBuffer>> entries;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleCache)
+};
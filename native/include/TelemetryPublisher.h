@@ -0,0 +1,95 @@
+#pragma once
+
+// Individual JUCE module includes
+#include <juce_core/juce_core.h>
+
+#include "AudioEngine.h"
+#include <atomic>
+#include <vector>
+
+/**
+ * @brief Publishes meters, cue playheads and the engine clock into a flat
+ * memory block that JavaScript reads directly
+ *
+ * A background thread copies the engine's lock-free meters and the cue
+ * positions into the attached block at a fixed rate, wrapped in a seqlock:
+ * the sequence word is odd while a write is in progress, so a reader takes
+ * the sequence, copies what it needs and retries if the sequence changed or
+ * was odd. The audio thread is never involved.
+ *
+ * Layout (native byte order, offsets in bytes):
+ *   0   int32   sequence
+ *   4   int32   LAYOUT_VERSION
+ *   8   int32   numInputs (buses)
+ *   12  int32   numOutputs (mixer outputs)
+ *   16  int32   numDeviceOutputs
+ *   20  int32   maxCues (slot capacity)
+ *   24  int32   numCues (slots in use)
+ *   28  int32   cueSlotGeneration (changes when slot -> cue id mapping changes)
+ *   32  float64 samplePosition (engine clock)
+ *   40  float64 sampleRate
+ *   48  ...     reserved up to HEADER_BYTES
+ *   HEADER_BYTES: float32 meters, METER_FLOATS per channel (peak, rms,
+ *                 peakHold) for inputs, then outputs, then device outputs
+ *                 (outputs read zero while the patch is fused; opt in with
+ *                 AudioEngine::setBusMetering)
+ *   then:         float32 cue slots, CUE_FLOATS per slot (position seconds,
+ *                 duration seconds, state flags: 1 playing, 2 paused, 4 scheduled)
+ *
+ * Slot order follows getCueIds(); re-read it when cueSlotGeneration changes.
+ */
+class TelemetryPublisher : private juce::Thread
+{
+public:
+    static constexpr int LAYOUT_VERSION = 1;
+    static constexpr int HEADER_BYTES = 64;
+    static constexpr int METER_FLOATS = 3;
+    static constexpr int CUE_FLOATS = 3;
+    static constexpr int DEFAULT_MAX_CUES = 256;
+    static constexpr int MAX_CUES = 65536; // Upper bound on slot capacity; attach() refuses more
+    static constexpr int DEFAULT_INTERVAL_MS = 16;
+
+    explicit TelemetryPublisher(AudioEngine& engine);
+    ~TelemetryPublisher() override;
+
+    // Bytes needed for the engine's current channel counts (maxCues clamped to MAX_CUES)
+    size_t getRequiredBytes(int maxCues) const;
+
+    // Starts writing into data (which must stay valid until detach()); the
+    // block is sized for the engine's channel counts at the time of the call
+    bool attach(void* data, size_t numBytes, int maxCues);
+    void detach();
+
+    void setIntervalMs(int intervalMs);
+
+    // Cue id for every slot in use, in slot order, and the generation it belongs to
+    juce::StringArray getCueIds(juce::int32& generation) const;
+
+private:
+    void run() override;
+    void publish();
+    void updateCueSlots();
+
+    AudioEngine& engine;
+
+    juce::CriticalSection bufferLock;
+    juce::uint8* buffer = nullptr;
+    size_t bufferBytes = 0;
+    int cueCapacity = 0;
+    int numInputs = 0;
+    int numOutputs = 0;
+    int numDeviceOutputs = 0;
+
+    std::atomic<int> intervalMs{DEFAULT_INTERVAL_MS};
+
+    // Publisher thread scratch, reused between publishes
+    AudioEngine::Meters meters;
+    std::vector<AudioEngine::Playhead> playheads;
+    
+    // Cue id per slot, guarded by slotLock so getCueIds() can run on the JS thread
+    juce::CriticalSection slotLock;
+    juce::StringArray slotIds;
+    juce::int32 slotGeneration = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TelemetryPublisher)
+};
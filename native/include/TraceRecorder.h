@@ -0,0 +1,141 @@
+#pragma once
+
+// Individual JUCE module includes
+#include <juce_core/juce_core.h>
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief Flight recorder of timed spans from every engine thread, exported
+ * as Chrome trace event JSON
+ *
+ * Each thread that records gets its own ring of TraceEvents the first time
+ * it records, claimed from a pool allocated by the first start(), so nothing
+ * is allocated or locked on the audio thread. A thread gives its ring back
+ * when it exits; the ring stays in the export until the next start() makes
+ * it claimable again. Threads that find the pool full record nothing for
+ * the rest of the capture and are counted in getNumDroppedThreads().
+ *
+ * A span is one event holding its begin and end ticks; when a ring wraps the
+ * oldest spans are overwritten, so the export always covers the most recent
+ * activity on each thread. While recording is off a Scope costs one relaxed
+ * load.
+ *
+ * Names and categories must be string literals or otherwise outlive the
+ * recorder; only the pointer is stored. The export opens directly in
+ * chrome://tracing and ui.perfetto.dev.
+ */
+class TraceRecorder
+{
+public:
+    static constexpr int MAX_THREADS = 32;
+    static constexpr int EVENTS_PER_THREAD = 16384; // Power of two
+    static constexpr int THREAD_NAME_BYTES = 32;
+
+    static TraceRecorder& getInstance();
+
+    // Control thread. start() begins a new capture (earlier events are left
+    // out of the export), stop() freezes it for exporting
+    void start();
+    void stop();
+    static bool isRecording() { return recording.load(std::memory_order_relaxed); }
+
+    // Any thread; times are juce::Time::getHighResolutionTicks()
+    void addSpan(const char* category, const char* name, juce::int64 startTicks, juce::int64 endTicks,
+                 juce::int64 value = 0);
+    void addInstant(const char* category, const char* name, juce::int64 value = 0);
+
+    // Labels the calling thread in the export unless it already has a name
+    // (JUCE threads are named after themselves)
+    void setThreadName(const char* name);
+
+    // Control thread: the current capture as a trace event JSON document.
+    // Returns the number of events written
+    int writeChromeTrace(juce::OutputStream& output) const;
+    
+    // Threads in the current capture that wanted a ring when none was free
+    int getNumDroppedThreads() const { return droppedThreads.load(); }
+
+    // Times one scope on the calling thread
+    class Scope
+    {
+    public:
+        Scope(const char* spanCategory, const char* spanName, juce::int64 spanValue = 0)
+            : category(spanCategory), name(spanName), value(spanValue)
+            , startTicks(isRecording() ? juce::Time::getHighResolutionTicks() : 0)
+        {
+        }
+
+        ~Scope()
+        {
+            if (startTicks != 0 && isRecording()) {
+                getInstance().addSpan(category, name, startTicks, juce::Time::getHighResolutionTicks(), value);
+            }
+        }
+
+    private:
+        const char* const category;
+        const char* const name;
+        const juce::int64 value;
+        const juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+
+private:
+    TraceRecorder() = default;
+
+    // Written by the owning thread only; fields are atomic so the exporter
+    // can read a slot while it is being overwritten and detect it afterwards
+    struct TraceEvent
+    {
+        std::atomic<const char*> category{nullptr};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<juce::int64> startTicks{0};
+        std::atomic<juce::int64> endTicks{0};   // Equal to startTicks for instants
+        std::atomic<juce::int64> value{0};
+    };
+
+    enum SlotState
+    {
+        slotFree,       // Claimable
+        slotClaimed,    // Owned by a live thread
+        slotReleased    // Owner exited; exported until start() frees it
+    };
+
+    struct ThreadBuffer
+    {
+        std::atomic<int> state{slotFree};
+        std::unique_ptr<TraceEvent[]> events { new TraceEvent[EVENTS_PER_THREAD] };
+        std::atomic<juce::uint64> startedIndex{0}; // Bumped before a slot is overwritten
+        std::atomic<juce::uint64> writeIndex{0};   // Bumped once it is complete
+        juce::uint64 captureStart = 0;             // Control thread, set by start()
+        std::atomic<bool> named{false};
+        char threadName[THREAD_NAME_BYTES] = {};
+    };
+
+    // Per thread: its ring, handed back by the destructor when the thread exits
+    struct ThreadClaim
+    {
+        ThreadBuffer* buffer = nullptr;
+        juce::uint32 failedCapture = 0; // Capture in which a claim found the pool full
+        ~ThreadClaim();
+    };
+    static thread_local ThreadClaim threadClaim;
+
+    ThreadBuffer* getThreadBuffer();
+    void push(ThreadBuffer& buffer, const char* category, const char* name,
+              juce::int64 startTicks, juce::int64 endTicks, juce::int64 value);
+
+    static std::atomic<bool> recording;
+
+    juce::CriticalSection controlLock;
+    std::unique_ptr<ThreadBuffer[]> buffers;
+    std::atomic<ThreadBuffer*> bufferPool{nullptr};
+    std::atomic<juce::uint32> captureNumber{0};
+    std::atomic<int> droppedThreads{0};
+    juce::int64 captureStartTicks = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TraceRecorder)
+};
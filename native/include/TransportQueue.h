@@ -0,0 +1,65 @@
+#pragma once
+
+// Individual JUCE module includes
+#include <juce_core/juce_core.h>
+
+#include "FadeEngine.h"
+
+#include <vector>
+
+class AudioCue;
+
+/**
+ * @brief A transport change for one cue, applied on the audio thread
+ */
+struct TransportCommand
+{
+    enum class Type
+    {
+        play,
+        stop,
+        pause,
+        resume,
+        stopAll,
+        go          // Hand the cue to the sequencer (pre-wait, follow-ons)
+    };
+
+    Type type = Type::stop;
+    AudioCue* cue = nullptr;   // Unused for stopAll
+    double startTime = 0.0;    // play only: offset into the file in seconds
+    juce::int64 startSample = -1; // play/go: engine sample position, -1 = now
+    double fadeTime = 0.0;     // Fade in for play, fade out for stop/stopAll
+    FadeCurve fadeCurve = FadeCurve::linear;
+};
+
+/**
+ * @brief Wait-free single-producer/single-consumer FIFO of transport commands
+ *
+ * The control thread (serialised by AudioEngine::cueMapLock) pushes commands
+ * and the audio callback drains them at the top of every block, so each
+ * transport change lands atomically on a block boundary and never races the
+ * cue's own per-block fade and position updates.
+ */
+class TransportQueue
+{
+public:
+    static constexpr int DEFAULT_CAPACITY = 1024;
+
+    explicit TransportQueue(int capacity = DEFAULT_CAPACITY);
+    ~TransportQueue();
+
+    // Producer side (control thread)
+    bool push(const TransportCommand& command);
+
+    // Consumer side (audio thread)
+    bool pop(TransportCommand& command);
+
+    int getNumPending() const { return fifo.getNumReady(); }
+    bool isEmpty() const { return getNumPending() == 0; }
+
+private:
+    juce::AbstractFifo fifo;
+    std::vector<TransportCommand> commands;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TransportQueue)
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+// Individual JUCE module includes
+#include <juce_core/juce_core.h>
+#include <juce_audio_devices/juce_audio_devices.h>
+
+#include <atomic>
+
+/**
+ * @brief Output-only audio device with no hardware behind it
+ *
+ * A real-time thread calls the audio callback once per buffer period against
+ * the high-resolution clock, exactly as a sound card driver would, and throws
+ * the output away. Optional jitter delays each callback by a random amount up
+ * to jitterMs so scheduling slack can be tested. Used for headless soak tests
+ * and CI boxes without a sound card.
+ */
+class VirtualAudioDevice : public juce::AudioIODevice,
+                           private juce::Thread
+{
+public:
+    static constexpr const char* TYPE_NAME = "Virtual";
+    static constexpr const char* DEVICE_NAME = "Virtual Output";
+    static constexpr int MAX_OUTPUTS = 512;
+
+    struct Settings
+    {
+        double sampleRate = 48000.0;
+        int bufferSize = 512;
+        int numOutputs = 2;
+        double jitterMs = 0.0;
+    };
+
+    explicit VirtualAudioDevice(const Settings& settings);
+    ~VirtualAudioDevice() override;
+
+    // AudioIODevice
+    juce::StringArray getOutputChannelNames() override;
+    juce::StringArray getInputChannelNames() override { return {}; }
+    juce::Array<double> getAvailableSampleRates() override;
+    juce::Array<int> getAvailableBufferSizes() override;
+    int getDefaultBufferSize() override { return settings.bufferSize; }
+
+    juce::String open(const juce::BigInteger& inputChannels, const juce::BigInteger& outputChannels,
+                      double sampleRate, int bufferSizeSamples) override;
+    void close() override;
+    bool isOpen() override { return deviceOpen; }
+    void start(juce::AudioIODeviceCallback* callback) override;
+    void stop() override;
+    bool isPlaying() override { return isThreadRunning(); }
+    juce::String getLastError() override { return {}; }
+
+    int getCurrentBufferSizeSamples() override { return currentBufferSize; }
+    double getCurrentSampleRate() override { return currentSampleRate; }
+    int getCurrentBitDepth() override { return 32; }
+    juce::BigInteger getActiveOutputChannels() const override { return activeOutputs; }
+    juce::BigInteger getActiveInputChannels() const override { return {}; }
+    int getOutputLatencyInSamples() override { return currentBufferSize; }
+    int getInputLatencyInSamples() override { return 0; }
+
+private:
+    void run() override;
+
+    const Settings settings;
+
+    bool deviceOpen = false;
+    double currentSampleRate = 48000.0;
+    int currentBufferSize = 512;
+    juce::BigInteger activeOutputs;
+    juce::AudioBuffer<float> outputBuffer;
+
+    // Only changed while the thread is stopped: start() sets it before the
+    // thread starts and stop() clears it after joining, so run() reads it unlocked
+    juce::AudioIODeviceCallback* callback = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VirtualAudioDevice)
+};
+
+/**
+ * @brief Device type that offers a single VirtualAudioDevice
+ *
+ * Registered with the engine's AudioDeviceManager alongside the platform
+ * types; the settings it holds apply to the next device it creates.
+ */
+class VirtualAudioDeviceType : public juce::AudioIODeviceType
+{
+public:
+    VirtualAudioDeviceType();
+
+    void setSettings(const VirtualAudioDevice::Settings& newSettings) { settings = newSettings; }
+
+    // AudioIODeviceType
+    void scanForDevices() override {}
+    juce::StringArray getDeviceNames(bool wantInputNames) const override;
+    int getDefaultDeviceIndex(bool forInput) const override { return forInput ? -1 : 0; }
+    int getIndexOfDevice(juce::AudioIODevice* device, bool asInput) const override;
+    bool hasSeparateInputsAndOutputs() const override { return true; }
+    juce::AudioIODevice* createDevice(const juce::String& outputDeviceName,
+                                      const juce::String& inputDeviceName) override;
+
+private:
+    VirtualAudioDevice::Settings settings;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VirtualAudioDeviceType)
+};
@@ -1,15 +1,17 @@
 #include "../include/AudioCue.h"
 #include "../include/MatrixMixer.h"
+#include "../include/DiskStreamer.h"
+#include "../include/TraceRecorder.h"
 
-AudioCue::AudioCue(const juce::String& id, MatrixMixer* mixer)
+AudioCue::AudioCue(const juce::String& id, MatrixMixer* mixer,
+                   juce::AudioFormatManager* formats, DiskStreamer* streamer,
+                   SampleCache* cache)
     : cueId(id)
     , matrixMixer(mixer)
-    , readerSource(nullptr)
-    , transportSource(nullptr)
-    , resamplingSource(nullptr)
+    , formatManager(formats)
+    , diskStreamer(streamer)
+    , sampleCache(cache)
 {
-    // Initialize channel routing to default (no routing)
-    channelRouting.resize(8, -1); // Support up to 8 channels by default
 }
 
 AudioCue::~AudioCue()
@@ -17,22 +19,85 @@ AudioCue::~AudioCue()
     unloadFile();
 }
 
+void AudioCue::prepareToPlay(double newOutputSampleRate, int maximumBlockSize)
+{
+    const bool rateChanged = newOutputSampleRate != outputSampleRate.load();
+    outputSampleRate.store(newOutputSampleRate);
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+    processingBuffer.setSize(juce::jmax(1, numChannels.load()), maxBlockSize);
+    fade.prepare(maxBlockSize);
+    
+    // Re-prepare the stream for the new rate while no worker is servicing it
+    if (diskStream) {
+        if (diskStreamer) {
+            diskStreamer->removeStream(diskStream.get());
+        }
+        
+        diskStream->prepare(newOutputSampleRate);
+        
+        if (diskStreamer && !isPreloaded()) {
+            diskStreamer->addStream(diskStream.get());
+        }
+    }
+    
+    // Resident audio is stored at the output rate, so decode it again
+    if (isPreloaded() && rateChanged) {
+        if (auto audio = decodeIntoMemory()) {
+            preloadedAudio = std::move(audio);
+        } else {
+            releasePreload();
+        }
+    }
+}
+
 bool AudioCue::loadFile(const juce::String& filePath)
 {
     unloadFile();
     
     audioFile = juce::File(filePath);
-    if (!audioFile.existsAsFile()) {
+    if (!audioFile.existsAsFile() || formatManager == nullptr) {
         return false;
     }
     
-    // For now, just mark as loaded - full implementation would use JUCE AudioFormatReader
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager->createReaderFor(audioFile));
+    if (reader == nullptr || reader->sampleRate <= 0.0) {
+        return false;
+    }
+    
+    numChannels.store(static_cast<int>(reader->numChannels));
+    sampleRate.store(reader->sampleRate);
+    lengthInSeconds.store(static_cast<double>(reader->lengthInSamples) / reader->sampleRate);
+    
+    processingBuffer.setSize(juce::jmax(1, numChannels.load()), maxBlockSize);
+    
+    // A file another cue already holds in RAM is shared as it is, with no
+    // read-ahead ring and no disk reads; otherwise prime the ring from the top
+    if (auto shared = findSharedAudio()) {
+        preloadedAudio = std::move(shared);
+        memoryPosition.store(0);
+    } else {
+        openDiskStream(std::move(reader));
+    }
+    
     fileLoaded.store(true);
-    numChannels.store(2); // Assume stereo for now
-    sampleRate.store(44100.0);
-    lengthInSeconds.store(60.0); // Assume 1 minute for now
+    return true;
+}
+
+bool AudioCue::openDiskStream(std::unique_ptr<juce::AudioFormatReader> reader)
+{
+    if (reader == nullptr && formatManager != nullptr) {
+        reader.reset(formatManager->createReaderFor(audioFile));
+    }
+    if (reader == nullptr) {
+        return false;
+    }
     
-    initializeSources();
+    diskStream = std::make_unique<DiskStream>(std::move(reader));
+    diskStream->prepare(outputSampleRate.load());
+    
+    if (diskStreamer) {
+        diskStreamer->addStream(diskStream.get());
+    }
     return true;
 }
 
@@ -42,39 +107,166 @@ void AudioCue::unloadFile()
         stop(0.0);
     }
     
-    readerSource.reset();
-    transportSource.reset();
-    resamplingSource.reset();
-    
     fileLoaded.store(false);
+    preloadedAudio.reset();
+    playingFromMemory.store(false);
+    
+    if (diskStream) {
+        if (diskStreamer) {
+            diskStreamer->removeStream(diskStream.get());
+        }
+        diskStream.reset();
+    }
+    
     numChannels.store(0);
     sampleRate.store(0.0);
     lengthInSeconds.store(0.0);
 }
 
-bool AudioCue::play(double startTime, double fadeInTime)
+SampleCache::SharedBuffer AudioCue::findSharedAudio() const
+{
+    if (sampleCache == nullptr || !audioFile.existsAsFile()) {
+        return nullptr;
+    }
+    
+    return sampleCache->find(SampleCache::makeKey(audioFile, outputSampleRate.load()));
+}
+
+SampleCache::SharedBuffer AudioCue::decodeIntoMemory() const
+{
+    if (formatManager == nullptr || !audioFile.existsAsFile()) {
+        return nullptr;
+    }
+    
+    // Another cue may already hold this file at this rate
+    if (auto shared = findSharedAudio()) {
+        return shared;
+    }
+    
+    const TraceRecorder::Scope trace("decode", "decodeIntoMemory");
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager->createReaderFor(audioFile));
+    if (reader == nullptr || reader->sampleRate <= 0.0 || reader->lengthInSamples <= 0) {
+        return nullptr;
+    }
+    
+    const int channels = static_cast<int>(reader->numChannels);
+    const int sourceLength = static_cast<int>(reader->lengthInSamples);
+    const double ratio = reader->sampleRate / outputSampleRate.load();
+    
+    // Decode the whole file, with a little zero padding for the interpolator
+    juce::AudioBuffer<float> source(channels, sourceLength + 8);
+    source.clear();
+    if (!reader->read(source.getArrayOfWritePointers(), channels, 0, sourceLength)) {
+        return nullptr;
+    }
+    
+    std::shared_ptr<juce::AudioBuffer<float>> audio;
+    if (std::abs(ratio - 1.0) < 1.0e-9) {
+        audio = std::make_shared<juce::AudioBuffer<float>>(channels, sourceLength);
+        for (int ch = 0; ch < channels; ++ch) {
+            audio->copyFrom(ch, 0, source, ch, 0, sourceLength);
+        }
+    } else {
+        // Convert to the device rate once so playback is a plain copy
+        const int outputLength = static_cast<int>(sourceLength / ratio);
+        audio = std::make_shared<juce::AudioBuffer<float>>(channels, outputLength);
+        for (int ch = 0; ch < channels; ++ch) {
+            juce::LagrangeInterpolator interpolator;
+            interpolator.process(ratio, source.getReadPointer(ch), audio->getWritePointer(ch), outputLength);
+        }
+    }
+    
+    if (sampleCache == nullptr) {
+        return audio;
+    }
+    
+    return sampleCache->insert(SampleCache::makeKey(audioFile, outputSampleRate.load()), std::move(audio));
+}
+
+void AudioCue::setPreloadedAudio(SampleCache::SharedBuffer audio)
+{
+    if (!audio || playing.load()) {
+        return;
+    }
+    
+    preloadedAudio = std::move(audio);
+    memoryPosition.store(0);
+    
+    // Resident cues need no disk reads at all
+    if (diskStream && diskStreamer) {
+        diskStreamer->removeStream(diskStream.get());
+    }
+}
+
+bool AudioCue::releasePreload()
+{
+    if (!preloadedAudio || (playing.load() && playingFromMemory.load())) {
+        return false;
+    }
+    
+    // Fall back to streaming from a freshly primed ring, opening one if the
+    // cue has only ever played shared audio
+    if (diskStream) {
+        diskStream->seek(0);
+        if (diskStreamer) {
+            diskStreamer->addStream(diskStream.get());
+        }
+    } else if (!openDiskStream(nullptr)) {
+        return false;
+    }
+    
+    preloadedAudio.reset();
+    return true;
+}
+
+size_t AudioCue::getPreloadedBytes() const
+{
+    return preloadedAudio ? SampleCache::getBufferBytes(*preloadedAudio) : 0;
+}
+
+size_t AudioCue::estimatePreloadBytes() const
+{
+    const double seconds = lengthInSeconds.load();
+    const auto samples = static_cast<size_t>(std::ceil(seconds * outputSampleRate.load()));
+    return static_cast<size_t>(numChannels.load()) * samples * sizeof(float);
+}
+
+void AudioCue::cueStream(double startTime)
+{
+    if (!fileLoaded.load() || isPreloaded() || !diskStream || playing.load()
+        || transportInFlight.load() != 0) {
+        return;
+    }
+    
+    diskStream->seek(static_cast<juce::int64>(juce::jmax(0.0, startTime) * outputSampleRate.load()));
+}
+
+bool AudioCue::play(double startTime, double fadeInTime, juce::int64 startSample, FadeCurve fadeCurve)
 {
     if (!fileLoaded.load()) {
         return false;
     }
     
-    // Reset fade state
-    fadeState.active.store(false);
-    fadeState.currentLevel.store(1.0f);
-    fadeState.targetLevel.store(1.0f);
+    // Fades run at the device rate; a re-GO during a fade-out ramps back up
+    // from wherever the gain is instead of jumping
+    const int fadeSamples = static_cast<int>(fadeInTime * outputSampleRate.load());
+    if (!playing.load()) {
+        fade.setLevel(fadeSamples > 0 ? 0.0f : 1.0f);
+    }
+    fade.startFade(1.0f, fadeSamples, fadeCurve);
     
-    // Set up fade in if requested
-    if (fadeInTime > 0.0) {
-        fadeState.active.store(true);
-        fadeState.currentLevel.store(0.0f);
-        fadeState.targetLevel.store(1.0f);
-        
-        // Calculate fade step size (assuming 44.1kHz sample rate)
-        int totalSamples = static_cast<int>(fadeInTime * 44100.0);
-        fadeState.stepSize.store(1.0f / totalSamples);
-        fadeState.remainingSamples.store(totalSamples);
+    // Resident cues play from RAM; the choice is fixed until the cue stops.
+    // A stream cued by cueStream() is already there, so this seek costs nothing
+    if (!playing.load()) {
+        playingFromMemory.store(isPreloaded());
+        seekTo(juce::jmax(0.0, startTime));
+        awaitingStream.store(!playingFromMemory.load());
     }
     
+    // A scheduled start keeps the voice silent until the engine clock reaches it
+    scheduledStartSample.store(startSample);
+    reachedEnd.store(false);
+    
     playing.store(true);
     paused.store(false);
     stopRequested.store(false);
@@ -82,26 +274,22 @@ bool AudioCue::play(double startTime, double fadeInTime)
     return true;
 }
 
-bool AudioCue::stop(double fadeOutTime)
+bool AudioCue::stop(double fadeOutTime, FadeCurve fadeCurve)
 {
     if (!playing.load()) {
         return false;
     }
     
-    if (fadeOutTime > 0.0) {
-        // Set up fade out
-        fadeState.active.store(true);
-        fadeState.targetLevel.store(0.0f);
-        
-        // Calculate fade step size
-        int totalSamples = static_cast<int>(fadeOutTime * 44100.0);
-        float currentLevel = fadeState.currentLevel.load();
-        fadeState.stepSize.store(-currentLevel / totalSamples);
-        fadeState.remainingSamples.store(totalSamples);
+    // A voice that has not started yet has nothing to fade
+    if (fadeOutTime > 0.0 && !isScheduled()) {
+        // Fade out from the current gain; the voice stops when the ramp ends
+        fade.startFade(0.0f, static_cast<int>(fadeOutTime * outputSampleRate.load()), fadeCurve);
     } else {
         // Immediate stop
         playing.store(false);
         paused.store(false);
+        scheduledStartSample.store(-1);
+        rewind();
     }
     
     stopRequested.store(true);
@@ -128,10 +316,49 @@ bool AudioCue::resume()
     return true;
 }
 
+int AudioCue::takeVoiceChanges()
+{
+    const bool nowPlaying = playing.load();
+    const bool nowFading = nowPlaying && fade.isFading();
+    
+    // A fade-out that completes ends the voice, so it reports as voiceEnded
+    int changes = 0;
+    if (reportedPlaying && !nowPlaying) {
+        changes |= voiceEnded;
+    } else if (reportedFading && !nowFading) {
+        changes |= fadeFinished;
+    }
+    
+    reportedPlaying = nowPlaying;
+    reportedFading = nowFading;
+    return changes;
+}
+
 double AudioCue::getCurrentTime() const
 {
-    // Implementation placeholder - would use transport source position
-    return 0.0;
+    if (playingFromMemory.load()) {
+        return static_cast<double>(memoryPosition.load()) / outputSampleRate.load();
+    }
+    
+    if (!diskStream) {
+        return 0.0;
+    }
+    
+    return static_cast<double>(diskStream->getPosition()) / outputSampleRate.load();
+}
+
+bool AudioCue::isStreamReady(int numSamples) const
+{
+    if (!playing.load() || paused.load() || playingFromMemory.load() || !diskStream) {
+        return true;
+    }
+    
+    return diskStream->isReadyFor(numSamples);
+}
+
+int AudioCue::getNumUnderruns() const
+{
+    return diskStream ? diskStream->getNumUnderruns() : 0;
 }
 
 double AudioCue::getDuration() const
@@ -139,44 +366,77 @@ double AudioCue::getDuration() const
     return lengthInSeconds.load();
 }
 
-void AudioCue::processAudioBlock(juce::AudioBuffer<float>& buffer, int numSamples)
+void AudioCue::processAudioBlock(juce::AudioBuffer<float>& buffer, int numSamples,
+                                 juce::int64 blockStartSample)
 {
-    if (!playing.load() || paused.load()) {
+    if (!playing.load() || paused.load() || (!diskStream && !playingFromMemory.load())) {
         return;
     }
     
-    // Ensure processing buffer is the right size
-    processingBuffer.setSize(numChannels.load(), numSamples, false, false, true);
-    processingBuffer.clear();
-    
-    // For now, generate silence - full implementation would read from audio source
-    // This is where we'd call transportSource->getNextAudioBlock()
-    
-    // Apply fade if active
-    if (fadeState.active.load()) {
-        updateFade(numSamples);
-        applyFadeToBuffer(processingBuffer, numSamples);
-    }
-    
-    // Route to matrix mixer inputs
-    for (int fileChannel = 0; fileChannel < numChannels.load(); ++fileChannel) {
-        int matrixInput = getInputChannel(fileChannel);
-        if (matrixInput >= 0 && matrixInput < 64) {
-            // Add this cue's audio to the matrix input
-            if (fileChannel < processingBuffer.getNumChannels() && 
-                matrixInput < buffer.getNumChannels()) {
-                buffer.addFrom(matrixInput, 0, processingBuffer, fileChannel, 0, numSamples);
+    // Scheduled starts begin at their exact sample inside the block; a late
+    // start (already in the past) begins at the top of the block
+    int startOffset = 0;
+    const auto scheduledStart = scheduledStartSample.load();
+    if (scheduledStart >= 0) {
+        if (scheduledStart >= blockStartSample + numSamples) {
+            return;
+        }
+        startOffset = static_cast<int>(juce::jmax<juce::int64>(0, scheduledStart - blockStartSample));
+    }
+    const int numToRender = numSamples - startOffset;
+    
+    // A streamed start waits for its first block rather than opening with an
+    // underrun; a scheduled one stays pending and begins late but intact
+    if (awaitingStream.load() && !playingFromMemory.load()) {
+        if (!diskStream->isReadyFor(numToRender)) {
+            if (stopRequested.load()) {
+                // Stopped before a sample was heard: nothing to fade
+                awaitingStream.store(false);
+                playing.store(false);
+                stopRequested.store(false);
+                scheduledStartSample.store(-1);
+                rewind();
             }
+            return;
         }
+        awaitingStream.store(false);
+    }
+    if (scheduledStart >= 0) {
+        scheduledStartSample.store(-1);
     }
     
+    // Ensure processing buffer is the right size
+    processingBuffer.setSize(numChannels.load(), numToRender, false, false, true);
+    
+    // Pull pre-decoded audio from RAM or the read-ahead ring; an underrun plays silence
+    const int numRead = playingFromMemory.load() ? readFromMemory(processingBuffer, numToRender)
+                                                 : diskStream->read(processingBuffer, numToRender);
+    if (numRead < numToRender) {
+        processingBuffer.clear(numRead, numToRender - numRead);
+    }
+    
+    // Per-sample fade gain
+    fade.process(processingBuffer, 0, numToRender);
+    
+    // Sum onto the matrix mixer inputs through this cue's own matrix
+    matrix.process(processingBuffer, numChannels.load(), buffer, startOffset, numToRender);
+    
     // Check if fade out is complete
-    if (stopRequested.load() && fadeState.active.load() && 
-        fadeState.remainingSamples.load() <= 0) {
+    if (stopRequested.load() && !fade.isFading()) {
         playing.store(false);
         paused.store(false);
         stopRequested.store(false);
-        fadeState.active.store(false);
+        rewind();
+    }
+    
+    // Check if the end of the file has been reached
+    if (playing.load() && isSourceFinished()) {
+        reachedEnd.store(true);
+        playing.store(false);
+        paused.store(false);
+        stopRequested.store(false);
+        fade.setLevel(1.0f);
+        rewind();
     }
 }
 
@@ -195,65 +455,50 @@ double AudioCue::getSampleRate() const
     return sampleRate.load();
 }
 
-bool AudioCue::setInputChannel(int fileChannel, int matrixInput)
+void AudioCue::seekTo(double seconds)
 {
-    if (fileChannel >= 0 && fileChannel < static_cast<int>(channelRouting.size())) {
-        channelRouting[fileChannel] = matrixInput;
-        return true;
+    const auto position = static_cast<juce::int64>(seconds * outputSampleRate.load());
+    
+    if (playingFromMemory.load()) {
+        const auto length = preloadedAudio ? static_cast<juce::int64>(preloadedAudio->getNumSamples()) : 0;
+        memoryPosition.store(juce::jlimit<juce::int64>(0, length, position));
+    } else if (diskStream) {
+        diskStream->seek(position);
     }
-    return false;
 }
 
-int AudioCue::getInputChannel(int fileChannel) const
+void AudioCue::rewind()
 {
-    if (fileChannel >= 0 && fileChannel < static_cast<int>(channelRouting.size())) {
-        return channelRouting[fileChannel];
+    // Lets the disk worker refill from the top so the next play starts instantly
+    memoryPosition.store(0);
+    if (diskStream) {
+        diskStream->seek(0);
     }
-    return -1;
 }
 
-void AudioCue::initializeSources()
+int AudioCue::readFromMemory(juce::AudioBuffer<float>& destination, int numSamples)
 {
-    // Implementation placeholder - would create JUCE transport and reader sources
-}
-
-void AudioCue::updateFade(int numSamples)
-{
-    if (!fadeState.active.load()) {
-        return;
+    if (!preloadedAudio) {
+        return 0;
     }
     
-    int remainingSamples = fadeState.remainingSamples.load();
-    int samplesToProcess = juce::jmin(numSamples, remainingSamples);
+    const auto position = memoryPosition.load();
+    const auto remaining = static_cast<juce::int64>(preloadedAudio->getNumSamples()) - position;
+    const int numToCopy = static_cast<int>(juce::jlimit<juce::int64>(0, numSamples, remaining));
     
-    if (samplesToProcess > 0) {
-        float stepSize = fadeState.stepSize.load();
-        float newLevel = fadeState.currentLevel.load() + (stepSize * samplesToProcess);
-        
-        // Clamp to target level
-        float targetLevel = fadeState.targetLevel.load();
-        if (stepSize > 0.0f) {
-            newLevel = juce::jmin(newLevel, targetLevel);
-        } else {
-            newLevel = juce::jmax(newLevel, targetLevel);
-        }
-        
-        fadeState.currentLevel.store(newLevel);
-        fadeState.remainingSamples.store(remainingSamples - samplesToProcess);
-        
-        // Check if fade is complete
-        if (fadeState.remainingSamples.load() <= 0) {
-            fadeState.currentLevel.store(targetLevel);
-            fadeState.active.store(false);
-        }
+    for (int ch = 0; ch < juce::jmin(destination.getNumChannels(), preloadedAudio->getNumChannels()); ++ch) {
+        destination.copyFrom(ch, 0, *preloadedAudio, ch, static_cast<int>(position), numToCopy);
     }
+    
+    memoryPosition.store(position + numToCopy);
+    return numToCopy;
 }
 
-void AudioCue::applyFadeToBuffer(juce::AudioBuffer<float>& buffer, int numSamples)
+bool AudioCue::isSourceFinished() const
 {
-    float level = fadeState.currentLevel.load();
-    
-    for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
-        buffer.applyGain(channel, 0, numSamples, level);
+    if (playingFromMemory.load()) {
+        return !preloadedAudio || memoryPosition.load() >= preloadedAudio->getNumSamples();
     }
-}
\ No newline at end of file
+    
+    return !diskStream || diskStream->isFinished();
+}
@@ -2,6 +2,12 @@
 #include "../include/MatrixMixer.h"
 #include "../include/OutputPatch.h"
 #include "../include/AudioCue.h"
+#include "../include/TraceRecorder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <thread>
 
 // AudioEngine implementation
 AudioEngine::AudioEngine()
@@ -9,27 +15,92 @@ AudioEngine::AudioEngine()
     , deviceManager(std::make_unique<juce::AudioDeviceManager>())
     , mixer(std::make_unique<MatrixMixer>())
     , outputPatch(std::make_unique<OutputPatch>())
+    , diskStreamer(std::make_unique<DiskStreamer>())
+    , sampleCache(std::make_unique<SampleCache>())
+    , transportQueue(std::make_unique<TransportQueue>())
+    , cueSequencer(std::make_unique<CueSequencer>())
 {
     initializeAudioFormats();
+    refreshPatchFusion();
+    
+    eventThread = std::make_unique<EventThread>(*this);
+    eventThread->startThread();
 }
 
 AudioEngine::~AudioEngine()
 {
+    cancelOfflineRender();
     shutdown();
+    eventThread.reset();
 }
 
-bool AudioEngine::initialize()
+bool AudioEngine::initialize(int numDeviceOutputs, int numBuses, int numMixerOutputs)
 {
     if (initialized.load()) {
         return true;
     }
     
+    // The offline renderer is driving the callback
+    if (isOfflineRendering()) {
+        return false;
+    }
+    
     // Initialize audio device manager
-    juce::String error = deviceManager->initialise(0, 2, nullptr, true);
+    juce::String error = deviceManager->initialise(0, juce::jmax(1, numDeviceOutputs), nullptr, true);
+    if (error.isNotEmpty()) {
+        return false;
+    }
+    
+    return startDevice(numBuses, numMixerOutputs, numDeviceOutputs);
+}
+
+bool AudioEngine::initializeVirtual(const VirtualAudioDevice::Settings& settings, int numBuses, int numMixerOutputs)
+{
+    if (initialized.load()) {
+        return true;
+    }
+    
+    if (isOfflineRendering() || settings.sampleRate <= 0.0 || settings.bufferSize <= 0
+        || settings.numOutputs < 1 || settings.numOutputs > VirtualAudioDevice::MAX_OUTPUTS) {
+        return false;
+    }
+    
+    // Make sure the platform types exist first; adding ours to an empty
+    // list would stop the manager from ever creating them
+    if (virtualDeviceType == nullptr) {
+        deviceManager->getAvailableDeviceTypes();
+        auto type = std::make_unique<VirtualAudioDeviceType>();
+        virtualDeviceType = type.get();
+        deviceManager->addAudioDeviceType(std::move(type));
+    }
+    virtualDeviceType->setSettings(settings);
+    deviceManager->setCurrentAudioDeviceType(VirtualAudioDevice::TYPE_NAME, false);
+    
+    juce::AudioDeviceManager::AudioDeviceSetup setup;
+    setup.outputDeviceName = VirtualAudioDevice::DEVICE_NAME;
+    setup.sampleRate = settings.sampleRate;
+    setup.bufferSize = settings.bufferSize;
+    setup.useDefaultInputChannels = false;
+    setup.useDefaultOutputChannels = false;
+    setup.outputChannels.setRange(0, settings.numOutputs, true);
+    
+    juce::String error = deviceManager->setAudioDeviceSetup(setup, false);
     if (error.isNotEmpty()) {
         return false;
     }
     
+    return startDevice(numBuses, numMixerOutputs, settings.numOutputs);
+}
+
+bool AudioEngine::startDevice(int numBuses, int numMixerOutputs, int requestedOutputs)
+{
+    // Size the mixer and patch for this rig before the callback can run
+    int openedOutputs = requestedOutputs;
+    if (auto* device = deviceManager->getCurrentAudioDevice()) {
+        openedOutputs = device->getActiveOutputChannels().countNumberOfSetBits();
+    }
+    configureChannels(numBuses, numMixerOutputs, openedOutputs);
+    
     // Set up audio callback
     deviceManager->addAudioCallback(this);
     
@@ -81,8 +152,35 @@ AudioEngine::Status AudioEngine::getStatus() const
     status.sampleRate = currentSampleRate.load();
     status.bufferSize = currentBufferSize.load();
     status.cpuUsage = cpuUsage.load();
+    status.peakCpuUsage = peakCpuUsage.load();
+    status.lastCallbackMs = lastCallbackMs.load();
     status.dropoutCount = dropoutCount.load();
+    status.overrunCount = overrunCount.load();
+    status.lateCallbackCount = lateCallbackCount.load();
+    status.diskUnderruns = 0;
+    {
+        juce::ScopedLock lock(cueMapLock);
+        for (const auto& pair : audioCues) {
+            status.diskUnderruns += pair.second->getNumUnderruns();
+        }
+    }
+    status.numDiskStreams = diskStreamer->getNumStreams();
     status.currentDevice = getCurrentDevice();
+    status.preloadBudgetBytes = static_cast<juce::int64>(preloadBudget.load());
+    status.preloadedBytes = static_cast<juce::int64>(preloadedBytes.load());
+    status.numPreloadedCues = numPreloadedCues.load();
+    status.numSharedSamples = sampleCache->getNumEntries();
+    status.sharedSampleBytes = static_cast<juce::int64>(sampleCache->getTotalBytes());
+    status.renderThreads = numRenderThreads.load();
+    status.patchFusionEnabled = patchFusionEnabled.load();
+    status.busMetering = busMeteringEnabled.load();
+    status.patchFused = mixer->isPatchFused();
+    status.mixKernel = MixKernel::getImplementationName();
+    status.numBuses = numBusChannels.load();
+    status.numMixerOutputs = numMixerOutputChannels.load();
+    status.numDeviceOutputs = outputPatch->getNumDeviceOutputs();
+    status.offlineRendering = isOfflineRendering();
+    status.offlineRenderedSeconds = offlineRenderer ? offlineRenderer->getRenderedSeconds() : 0.0;
     return status;
 }
 
@@ -90,32 +188,148 @@ void AudioEngine::audioDeviceIOCallback(const float* const* inputChannelData,
                                        int numInputChannels,
                                        float* const* outputChannelData,
                                        int numOutputChannels,
-                                       int numSamples)
+                                       int numSamples,
+                                       const std::uint64_t* hostTimeNs)
 {
+    const juce::int64 startTicks = juce::Time::getHighResolutionTicks();
+    
     // Clear output buffers
     for (int i = 0; i < numOutputChannels; ++i) {
         juce::FloatVectorOperations::clear(outputChannelData[i], numSamples);
     }
     
+    const juce::int64 blockStart = samplePosition.load();
+    updateClockMapping(blockStart, numSamples, hostTimeNs);
+    
+    CueSnapshot* snapshot = acquireCueSnapshot();
+    juce::int64 stageStart = juce::Time::getHighResolutionTicks();
+    
+    // Apply queued transport changes on the block boundary, stopping short
+    // of any a transaction is still queueing
+    const juce::int64 released = transportReleased.load(std::memory_order_acquire);
+    applyPendingCueChanges(released);
+    consumeTransport(released, snapshot);
+    
+    // Fire sequencer triggers that fall inside this block before the cues render
+    const CueSequencer::Graph* sequence = snapshot != nullptr ? snapshot->sequence.get() : nullptr;
+    cueSequencer->process(sequence, blockStart, numSamples, currentSampleRate.load());
+    stageStart = recordStageTime(TimingStage::transport, stageStart);
+    
     // Process audio through mixer and output patch
     if (mixer && outputPatch) {
-        processAudioBlock(outputChannelData, numOutputChannels, numSamples);
+        processAudioBlock(snapshot, outputChannelData, numOutputChannels, numSamples, stageStart);
     }
+    
+    reportVoiceChanges(snapshot, blockStart + numSamples);
+    cueSequencer->checkCompletions(sequence, blockStart + numSamples);
+    samplePosition.store(blockStart + numSamples);
+    
+    // Done with the snapshot; retired ones can go even if no block follows
+    audioThreadSnapshot.store(nullptr);
+    
+    updatePerformanceMetrics(startTicks, numSamples);
+}
+
+void AudioEngine::audioDeviceIOCallbackWithContext(const float* const* inputChannelData,
+                                                   int numInputChannels,
+                                                   float* const* outputChannelData,
+                                                   int numOutputChannels,
+                                                   int numSamples,
+                                                   const juce::AudioIODeviceCallbackContext& context)
+{
+    audioDeviceIOCallback(inputChannelData, numInputChannels, outputChannelData, numOutputChannels, numSamples,
+                          context.hostTimeNs);
 }
 
 void AudioEngine::audioDeviceAboutToStart(juce::AudioIODevice* device)
 {
-    currentSampleRate.store(device->getCurrentSampleRate());
-    currentBufferSize.store(device->getCurrentBufferSizeSamples());
+    prepareToRender(device->getCurrentSampleRate(), device->getCurrentBufferSizeSamples(), true);
+}
+
+void AudioEngine::audioDeviceStopped()
+{
+    stopRendering();
+}
+
+void AudioEngine::prepareToRender(double sampleRate, int blockSize, bool realtime)
+{
+    currentSampleRate.store(sampleRate);
+    currentBufferSize.store(blockSize);
+    
+    // Fresh timing for the new stream; the dropout counters keep counting
+    // so a device restart doesn't hide earlier trouble
+    callbackTiming = CallbackTiming();
+    callbackTiming.realtime = realtime;
+    clockFilter = ClockFilter();
+    cpuUsage.store(0.0);
+    peakCpuUsage.store(0.0);
+    lastCallbackMs.store(0.0);
     
     // Prepare buffers
-    mixBuffer.setSize(64, device->getCurrentBufferSizeSamples());
-    tempBuffer.setSize(64, device->getCurrentBufferSizeSamples());
+    mixBuffer.setSize(numBusChannels.load(), blockSize);
+    tempBuffer.setSize(numMixerOutputChannels.load(), blockSize);
+    mixer->prepare(sampleRate, blockSize);
+    outputPatch->prepare(sampleRate);
+    
+    // Streams resample to the device rate, so re-prepare every cue
+    juce::ScopedLock lock(cueMapLock);
+    prepareWorkerBuses(blockSize);
+    for (auto& pair : audioCues) {
+        pair.second->prepareToPlay(sampleRate, blockSize);
+    }
+    updatePreloadUsage();
+    
+    // The clock keeps counting from where it stopped
+    clockOriginMs.store(juce::Time::getMillisecondCounterHiRes()
+                        - static_cast<double>(samplePosition.load()) * 1000.0 / sampleRate);
+    deviceRunning.store(true);
 }
 
-void AudioEngine::audioDeviceStopped()
+void AudioEngine::stopRendering()
+{
+    // Cleared before taking the lock: a control thread waiting in detachCue
+    // holds it, and drains the queue itself once it sees the device gone
+    deviceRunning.store(false);
+    
+    juce::ScopedLock lock(cueMapLock);
+    applyQueuedTransport();
+}
+
+void AudioEngine::applyQueuedTransport()
+{
+    // Nothing else drains the queue once the callback has stopped; called with
+    // cueMapLock held, which makes this the only consumer
+    applyPendingCueChanges(transportQueued);
+    consumeTransport(transportQueued, currentSnapshot.get());
+}
+
+void AudioEngine::consumeTransport(juce::int64 released, const CueSnapshot* snapshot)
 {
-    // Clean up when audio device stops
+    // A panic lands in queue order: after the commands queued before it
+    // was requested, ahead of any queued since
+    TransportCommand panic;
+    panic.type = TransportCommand::Type::stopAll;
+    bool panicPending = panicRequested.exchange(false, std::memory_order_acquire);
+    const juce::int64 panicAt = panicThrough.load(std::memory_order_relaxed);
+    
+    TransportCommand command;
+    while (transportApplied < released && transportQueue->pop(command)) {
+        if (panicPending && transportApplied >= panicAt) {
+            applyTransportCommand(panic, snapshot);
+            panicPending = false;
+        }
+        if (!isTransportSkipped(transportApplied)) {
+            applyTransportCommand(command, snapshot);
+        }
+        if (command.cue != nullptr) {
+            command.cue->transportApplied();
+        }
+        ++transportApplied;
+    }
+    
+    if (panicPending) {
+        applyTransportCommand(panic, snapshot);
+    }
 }
 
 bool AudioEngine::createAudioCue(const juce::String& cueId, const juce::String& filePath)
@@ -126,12 +340,24 @@ bool AudioEngine::createAudioCue(const juce::String& cueId, const juce::String&
         return false; // Cue already exists
     }
     
-    auto cue = std::make_unique<AudioCue>(cueId, mixer.get());
+    auto cue = std::make_unique<AudioCue>(cueId, mixer.get(), formatManager.get(),
+                                          diskStreamer.get(), sampleCache.get());
+    if (cue->getMatrix().getNumOutputs() != numBusChannels.load()) {
+        cue->getMatrix().configure(numBusChannels.load());
+    }
+    cue->prepareToPlay(currentSampleRate.load(), currentBufferSize.load());
     if (!cue->loadFile(filePath)) {
         return false;
     }
     
+    // A copy of a resident cue picked up the shared audio while loading
+    if (cue->isPreloaded()) {
+        touchPreload(cueId);
+    }
+    
     audioCues[cueId] = std::move(cue);
+    updatePreloadUsage();
+    publishCueSnapshot();
     return true;
 }
 
@@ -144,10 +370,20 @@ bool AudioEngine::loadAudioFile(const juce::String& cueId, const juce::String& f
         return false;
     }
     
-    return it->second->loadFile(filePath);
+    // The stream is replaced, so the audio thread must let go of the cue first
+    detachCue(it->second.get());
+    const bool loaded = it->second->loadFile(filePath);
+    preloadLru.remove(cueId);
+    if (loaded && it->second->isPreloaded()) {
+        touchPreload(cueId);
+    }
+    updatePreloadUsage();
+    publishCueSnapshot();
+    return loaded;
 }
 
-bool AudioEngine::playCue(const juce::String& cueId, double startTime, double fadeInTime)
+bool AudioEngine::playCue(const juce::String& cueId, double startTime, double fadeInTime,
+                          FadeCurve fadeCurve)
 {
     juce::ScopedLock lock(cueMapLock);
     
@@ -156,10 +392,24 @@ bool AudioEngine::playCue(const juce::String& cueId, double startTime, double fa
         return false;
     }
     
-    return it->second->play(startTime, fadeInTime);
+    if (!it->second->isLoaded()) {
+        return false;
+    }
+    
+    if (it->second->isPreloaded()) {
+        touchPreload(cueId);
+    }
+    
+    TransportCommand command;
+    command.type = TransportCommand::Type::play;
+    command.cue = it->second.get();
+    command.startTime = startTime;
+    command.fadeTime = fadeInTime;
+    command.fadeCurve = fadeCurve;
+    return dispatchTransport(command);
 }
 
-bool AudioEngine::stopCue(const juce::String& cueId, double fadeOutTime)
+bool AudioEngine::stopCue(const juce::String& cueId, double fadeOutTime, FadeCurve fadeCurve)
 {
     juce::ScopedLock lock(cueMapLock);
     
@@ -168,7 +418,12 @@ bool AudioEngine::stopCue(const juce::String& cueId, double fadeOutTime)
         return false;
     }
     
-    return it->second->stop(fadeOutTime);
+    TransportCommand command;
+    command.type = TransportCommand::Type::stop;
+    command.cue = it->second.get();
+    command.fadeTime = fadeOutTime;
+    command.fadeCurve = fadeCurve;
+    return dispatchTransport(command);
 }
 
 bool AudioEngine::pauseCue(const juce::String& cueId)
@@ -180,7 +435,10 @@ bool AudioEngine::pauseCue(const juce::String& cueId)
         return false;
     }
     
-    return it->second->pause();
+    TransportCommand command;
+    command.type = TransportCommand::Type::pause;
+    command.cue = it->second.get();
+    return dispatchTransport(command);
 }
 
 bool AudioEngine::resumeCue(const juce::String& cueId)
@@ -192,153 +450,1390 @@ bool AudioEngine::resumeCue(const juce::String& cueId)
         return false;
     }
     
-    return it->second->resume();
+    TransportCommand command;
+    command.type = TransportCommand::Type::resume;
+    command.cue = it->second.get();
+    return dispatchTransport(command);
 }
 
 void AudioEngine::stopAllCues()
 {
     juce::ScopedLock lock(cueMapLock);
     
-    for (auto& pair : audioCues) {
-        pair.second->stop(0.0);
+    TransportCommand command;
+    command.type = TransportCommand::Type::stopAll;
+    
+    // Inside a transaction the stop goes out with the rest when there is room
+    if (!deviceRunning.load() || transportHeld) {
+        if (dispatchTransport(command)) {
+            return;
+        }
     }
+    
+    // Otherwise a full queue can't lose it: the flag is checked every block,
+    // and by stopRendering() if the device goes away first
+    panicThrough.store(transportQueued, std::memory_order_relaxed);
+    panicRequested.store(true, std::memory_order_release);
 }
 
-bool AudioEngine::setCrosspoint(const juce::String& cueId, int input, int output, float level)
+bool AudioEngine::isCueLoaded(const juce::String& cueId) const
 {
-    if (!mixer) {
+    juce::ScopedLock lock(cueMapLock);
+    
+    auto it = audioCues.find(cueId);
+    return it != audioCues.end() && it->second->isLoaded();
+}
+
+bool AudioEngine::playCueAtSample(const juce::String& cueId, juce::int64 startSample,
+                                  double startTime, double fadeInTime, FadeCurve fadeCurve)
+{
+    juce::ScopedLock lock(cueMapLock);
+    
+    auto it = audioCues.find(cueId);
+    if (it == audioCues.end() || !it->second->isLoaded()) {
         return false;
     }
     
-    mixer->setCrosspoint(input, output, level);
-    return true;
+    if (it->second->isPreloaded()) {
+        touchPreload(cueId);
+    }
+    
+    TransportCommand command;
+    command.type = TransportCommand::Type::play;
+    command.cue = it->second.get();
+    command.startTime = startTime;
+    command.fadeTime = fadeInTime;
+    command.fadeCurve = fadeCurve;
+    command.startSample = juce::jmax<juce::int64>(0, startSample);
+    return dispatchTransport(command);
 }
 
-float AudioEngine::getCrosspoint(const juce::String& cueId, int input, int output) const
+bool AudioEngine::playCueAtHostTime(const juce::String& cueId, double hostTimeMs,
+                                    double startTime, double fadeInTime, FadeCurve fadeCurve)
 {
-    if (!mixer) {
-        return 0.0f;
+    return playCueAtSample(cueId, hostTimeToSamplePosition(hostTimeMs), startTime, fadeInTime, fadeCurve);
+}
+
+void AudioEngine::updateClockMapping(juce::int64 blockStart, int numSamples, const std::uint64_t* hostTimeNs)
+{
+    // The device's time stamp for the block when it gives one (on the platforms
+    // that do, it shares the millisecond counter's clock), otherwise the time
+    // the callback ran, whose scheduling jitter the loop filters out
+    const double nowMs = juce::Time::getMillisecondCounterHiRes();
+    double blockMs = nowMs;
+    if (hostTimeNs != nullptr) {
+        const double deviceMs = static_cast<double>(*hostTimeNs) * 1.0e-6;
+        if (std::abs(deviceMs - nowMs) < HOST_TIME_TOLERANCE_MS) {
+            blockMs = deviceMs;
+        }
+    }
+    
+    const double nominalMsPerSample = 1000.0 / currentSampleRate.load();
+    const double periodMs = numSamples * nominalMsPerSample;
+    const double error = blockMs - clockFilter.nextBlockMs;
+    
+    double filteredMs = blockMs;
+    if (!clockFilter.locked || numSamples <= 0 || std::abs(error) > CLOCK_RELOCK_PERIODS * periodMs) {
+        clockFilter.locked = true;
+        clockFilter.msPerSample = nominalMsPerSample;
+    } else {
+        // Critically damped second-order loop: the phase follows part of the
+        // error, the rate integrates it
+        const double omega = juce::MathConstants<double>::twoPi * CLOCK_BANDWIDTH_HZ * periodMs * 0.001;
+        filteredMs = clockFilter.nextBlockMs + juce::MathConstants<double>::sqrt2 * omega * error;
+        clockFilter.msPerSample += omega * omega * error / numSamples;
     }
+    clockFilter.nextBlockMs = filteredMs + numSamples * clockFilter.msPerSample;
     
-    return mixer->getCrosspoint(input, output);
+    // Host time of sample zero
+    clockOriginMs.store(filteredMs - static_cast<double>(blockStart) * nominalMsPerSample);
 }
 
-bool AudioEngine::setInputLevel(const juce::String& cueId, int input, float level)
+juce::int64 AudioEngine::hostTimeToSamplePosition(double hostTimeMs) const
 {
-    if (!mixer) {
+    const double elapsedMs = hostTimeMs - clockOriginMs.load();
+    return static_cast<juce::int64>(std::llround(elapsedMs * currentSampleRate.load() / 1000.0));
+}
+
+bool AudioEngine::setCueTiming(const juce::String& cueId, const CueSequencer::CueTiming& timing)
+{
+    juce::ScopedLock lock(cueMapLock);
+    
+    if (audioCues.find(cueId) == audioCues.end()) {
         return false;
     }
     
-    mixer->setInputLevel(input, level);
+    cueSequencer->setCueTiming(cueId, timing);
+    publishCueSnapshot();
     return true;
 }
 
-bool AudioEngine::setOutputLevel(int output, float level)
+bool AudioEngine::goCue(const juce::String& cueId, juce::int64 startSample)
 {
-    if (!mixer) {
+    juce::ScopedLock lock(cueMapLock);
+    
+    auto it = audioCues.find(cueId);
+    if (it == audioCues.end() || !it->second->isLoaded()) {
         return false;
     }
     
-    mixer->setOutputLevel(output, level);
-    return true;
+    TransportCommand command;
+    command.type = TransportCommand::Type::go;
+    command.cue = it->second.get();
+    command.startSample = startSample >= 0 ? startSample : samplePosition.load();
+    return dispatchTransport(command);
 }
 
-bool AudioEngine::muteOutput(int output, bool mute)
+void AudioEngine::setEventCallback(EventCallback callback)
 {
-    if (!mixer) {
+    juce::ScopedLock lock(eventLock);
+    eventCallback = std::move(callback);
+}
+
+bool AudioEngine::setRenderThreads(int numThreads)
+{
+    if (numThreads < 0 || numThreads >= RenderPool::MAX_WORKERS) {
         return false;
     }
     
-    mixer->muteOutput(output, mute);
+    juce::ScopedLock lock(cueMapLock);
+    
+    // Take the pool away from the audio thread before replacing it
+    auto oldPool = std::move(renderPool);
+    publishCueSnapshot();
+    waitForAudioThread();
+    oldPool.reset();
+    
+    if (numThreads > 0) {
+        renderPool = std::make_unique<RenderPool>(numThreads);
+    }
+    prepareWorkerBuses(currentBufferSize.load());
+    numRenderThreads.store(numThreads);
+    publishCueSnapshot();
     return true;
 }
 
-bool AudioEngine::soloOutput(int output, bool solo)
+bool AudioEngine::setCuePreload(const juce::String& cueId, bool preload)
 {
-    if (!mixer) {
+    AudioCue* cue = nullptr;
+    
+    {
+        juce::ScopedLock lock(cueMapLock);
+        
+        auto it = audioCues.find(cueId);
+        if (it == audioCues.end() || !it->second->isLoaded()) {
+            return false;
+        }
+        cue = it->second.get();
+        
+        if (!preload) {
+            if (cue->isPreloaded() && !releaseCuePreload(cue)) {
+                return false; // Still playing from RAM
+            }
+            preloadLru.remove(cueId);
+            updatePreloadUsage();
+            return true;
+        }
+        
+        if (cue->isPreloaded()) {
+            touchPreload(cueId);
+            return true;
+        }
+        
+        // Already decoded for another cue: sharing costs no budget
+        if (auto shared = cue->findSharedAudio()) {
+            detachCue(cue);
+            cue->setPreloadedAudio(std::move(shared));
+            publishCueSnapshot();
+            touchPreload(cueId);
+            updatePreloadUsage();
+            return cue->isPreloaded();
+        }
+        
+        if (!evictPreloadsFor(cue->estimatePreloadBytes())) {
+            return false; // Doesn't fit in the budget; the cue keeps streaming
+        }
+    }
+    
+    // Decode outside the lock so the audio thread never waits on the disk
+    auto audio = cue->decodeIntoMemory();
+    if (!audio) {
         return false;
     }
     
-    mixer->soloOutput(output, solo);
+    juce::ScopedLock lock(cueMapLock);
+    detachCue(cue);
+    cue->setPreloadedAudio(std::move(audio));
+    publishCueSnapshot();
+    if (!cue->isPreloaded()) {
+        return false; // Started playing while decoding
+    }
+    
+    touchPreload(cueId);
+    updatePreloadUsage();
     return true;
 }
 
-bool AudioEngine::setPatchRouting(int cueOutput, int deviceOutput, float level)
+void AudioEngine::setPreloadBudget(size_t budgetBytes)
 {
-    if (!outputPatch) {
+    juce::ScopedLock lock(cueMapLock);
+    
+    preloadBudget.store(budgetBytes);
+    evictPreloadsFor(0);
+}
+
+bool AudioEngine::setCrosspoint(const juce::String& cueId, int input, int output, float level, bool muted)
+{
+    // An empty cueId addresses the master MatrixMixer; otherwise the cue's own
+    // matrix (input = file channel, output = bus / mixer input)
+    if (cueId.isEmpty()) {
+        if (!mixer) {
+            return false;
+        }
+        
+        mixer->setCrosspoint(input, output, muted ? 0.0f : level);
+        return true;
+    }
+    
+    juce::ScopedLock lock(cueMapLock);
+    
+    auto it = audioCues.find(cueId);
+    if (it == audioCues.end()) {
         return false;
     }
     
-    outputPatch->setPatchRouting(cueOutput, deviceOutput, level);
+    writeCueMatrix({ CueMatrixChange::Type::crosspoint, it->second.get(), input, output, level, muted });
     return true;
 }
 
-float AudioEngine::getPatchRouting(int cueOutput, int deviceOutput) const
+float AudioEngine::getCrosspoint(const juce::String& cueId, int input, int output) const
 {
-    if (!outputPatch) {
+    if (cueId.isEmpty()) {
+        return mixer ? mixer->getCrosspoint(input, output) : 0.0f;
+    }
+    
+    juce::ScopedLock lock(cueMapLock);
+    
+    auto it = audioCues.find(cueId);
+    if (it == audioCues.end()) {
         return 0.0f;
     }
     
-    return outputPatch->getPatchRouting(cueOutput, deviceOutput);
+    return it->second->getMatrix().getCrosspoint(input, output);
 }
 
-void AudioEngine::initializeAudioFormats()
+bool AudioEngine::setInputLevel(const juce::String& cueId, int input, float level, bool muted)
 {
-    if (!formatManager) {
-        return;
+    if (cueId.isEmpty()) {
+        if (!mixer) {
+            return false;
+        }
+        
+        // One route rebuild for both changes
+        mixer->beginUpdate();
+        mixer->setInputLevel(input, level);
+        mixer->muteInput(input, muted);
+        mixer->endUpdate();
+        return true;
     }
     
-    // Register basic audio formats
-    formatManager->registerBasicFormats();
+    juce::ScopedLock lock(cueMapLock);
+    
+    auto it = audioCues.find(cueId);
+    if (it == audioCues.end()) {
+        return false;
+    }
+    
+    writeCueMatrix({ CueMatrixChange::Type::inputLevel, it->second.get(), input, 0, level, muted });
+    return true;
 }
 
-void AudioEngine::setupAudioDevice()
+bool AudioEngine::setCueOutputLevel(const juce::String& cueId, int output, float level, bool muted)
 {
-    // Implementation placeholder for device setup
+    juce::ScopedLock lock(cueMapLock);
+    
+    auto it = audioCues.find(cueId);
+    if (it == audioCues.end()) {
+        return false;
+    }
+    
+    writeCueMatrix({ CueMatrixChange::Type::outputLevel, it->second.get(), 0, output, level, muted });
+    return true;
 }
 
-void AudioEngine::processAudioBlock(float* const* outputChannelData, int numOutputChannels, int numSamples)
+bool AudioEngine::setCueMatrix(const juce::String& cueId, const std::vector<std::vector<float>>& levels)
 {
-    // Ensure buffers are the right size
-    mixBuffer.setSize(64, numSamples, false, false, true);
-    tempBuffer.setSize(64, numSamples, false, false, true);
+    juce::ScopedLock lock(cueMapLock);
     
-    // Clear mix buffer
-    mixBuffer.clear();
+    auto it = audioCues.find(cueId);
+    if (it == audioCues.end()) {
+        return false;
+    }
     
-    // Process all active cues
-    {
-        juce::ScopedLock lock(cueMapLock);
-        for (auto& pair : audioCues) {
-            if (pair.second->isPlaying()) {
-                pair.second->processAudioBlock(tempBuffer, numSamples);
-                
-                // Add to mix buffer
-                for (int ch = 0; ch < juce::jmin(tempBuffer.getNumChannels(), mixBuffer.getNumChannels()); ++ch) {
-                    mixBuffer.addFrom(ch, 0, tempBuffer, ch, 0, numSamples);
-                }
-            }
+    // Rows are file channels, columns are bus outputs; anything absent is silent
+    auto* cue = it->second.get();
+    const int numOutputs = cue->getMatrix().getNumOutputs();
+    for (int channel = 0; channel < CueMatrix::MAX_CHANNELS; ++channel) {
+        for (int output = 0; output < numOutputs; ++output) {
+            const auto row = static_cast<size_t>(channel);
+            const auto column = static_cast<size_t>(output);
+            const float level = row < levels.size() && column < levels[row].size() ? levels[row][column] : 0.0f;
+            writeCueMatrix({ CueMatrixChange::Type::crosspoint, cue, channel, output, level, false });
         }
     }
+    return true;
+}
+
+bool AudioEngine::setMatrix(const juce::String& cueId, const float* levels, int numInputs, int numOutputs)
+{
+    if (levels == nullptr || numInputs < 0 || numOutputs <= 0) {
+        return false;
+    }
     
-    // Process through matrix mixer
-    const float* const* mixInputs = mixBuffer.getArrayOfReadPointers();
-    float* const* mixOutputs = tempBuffer.getArrayOfWritePointers();
+    // Input-major flat levels, for callers that hold the matrix as one array
+    if (cueId.isEmpty()) {
+        if (!mixer) {
+            return false;
+        }
+        
+        mixer->setCrosspoints(levels, numInputs, numOutputs);
+        return true;
+    }
     
-    mixer->processAudioBlock(mixInputs, mixOutputs, 
-                           mixBuffer.getNumChannels(), 
-                           tempBuffer.getNumChannels(), 
-                           numSamples);
+    juce::ScopedLock lock(cueMapLock);
     
-    // Process through output patch
-    outputPatch->processAudioBlock(tempBuffer.getArrayOfReadPointers(),
-                                 outputChannelData,
-                                 tempBuffer.getNumChannels(),
-                                 numOutputChannels,
-                                 numSamples);
+    auto it = audioCues.find(cueId);
+    if (it == audioCues.end()) {
+        return false;
+    }
+    
+    auto* cue = it->second.get();
+    const int numCueOutputs = cue->getMatrix().getNumOutputs();
+    for (int channel = 0; channel < CueMatrix::MAX_CHANNELS; ++channel) {
+        for (int output = 0; output < numCueOutputs; ++output) {
+            const bool covered = channel < numInputs && output < numOutputs;
+            const float level = covered ? levels[channel * numOutputs + output] : 0.0f;
+            writeCueMatrix({ CueMatrixChange::Type::crosspoint, cue, channel, output, level, false });
+        }
+    }
+    return true;
+}
+
+bool AudioEngine::postCrosspoint(const juce::String& cueId, int input, int output, float level, bool muted)
+{
+    if (!cueId.isEmpty()) {
+        return setCrosspoint(cueId, input, output, level, muted);
+    }
+    if (!mixer) {
+        return false;
+    }
+    
+    mixer->postCrosspoint(input, output, muted ? 0.0f : level);
+    return true;
+}
+
+bool AudioEngine::postInputLevel(const juce::String& cueId, int input, float level, bool muted)
+{
+    if (!cueId.isEmpty()) {
+        return setInputLevel(cueId, input, level, muted);
+    }
+    if (!mixer) {
+        return false;
+    }
+    
+    mixer->postInputLevel(input, level, muted);
+    return true;
 }
 
-void AudioEngine::updatePerformanceMetrics()
+bool AudioEngine::postOutputLevel(int output, float level)
 {
-    // Implementation placeholder for performance monitoring
+    if (!mixer) {
+        return false;
+    }
+    
+    mixer->postOutputLevel(output, level);
+    return true;
+}
+
+bool AudioEngine::setOutputLevel(int output, float level)
+{
+    if (!mixer) {
+        return false;
+    }
+    
+    mixer->setOutputLevel(output, level);
+    return true;
+}
+
+bool AudioEngine::muteOutput(int output, bool mute)
+{
+    if (!mixer) {
+        return false;
+    }
+    
+    mixer->muteOutput(output, mute);
+    return true;
+}
+
+bool AudioEngine::soloOutput(int output, bool solo)
+{
+    if (!mixer) {
+        return false;
+    }
+    
+    mixer->soloOutput(output, solo);
+    return true;
+}
+
+AudioEngine::Meters AudioEngine::getMeters() const
+{
+    Meters meters;
+    getMeters(meters);
+    return meters;
+}
+
+void AudioEngine::getMeters(Meters& meters) const
+{
+    // configureChannels resizes the banks under the same lock
+    juce::ScopedLock lock(cueMapLock);
+    mixer->getInputMeters().getLevels(meters.inputs);
+    mixer->getOutputMeters().getLevels(meters.outputs);
+    outputPatch->getDeviceMeters().getLevels(meters.deviceOutputs);
+}
+
+void AudioEngine::getPlayheads(std::vector<Playhead>& playheads) const
+{
+    juce::ScopedLock lock(cueMapLock);
+    playheads.resize(audioCues.size());
+    
+    size_t slot = 0;
+    for (const auto& [cueId, cue] : audioCues) {
+        auto& playhead = playheads[slot++];
+        playhead.cueId = cueId;
+        playhead.currentTime = cue->getCurrentTime();
+        playhead.duration = cue->getDuration();
+        playhead.playing = cue->isPlaying();
+        playhead.paused = cue->isPaused();
+        playhead.scheduled = cue->isScheduled();
+    }
+}
+
+bool AudioEngine::setGainRampTime(float seconds)
+{
+    if (!mixer || seconds < 0.0f) {
+        return false;
+    }
+    
+    mixer->setRampTime(seconds);
+    return true;
+}
+
+bool AudioEngine::setPatchRouting(int cueOutput, int deviceOutput, float level)
+{
+    if (!outputPatch) {
+        return false;
+    }
+    
+    outputPatch->setPatchRouting(cueOutput, deviceOutput, level);
+    refreshPatchFusion();
+    return true;
+}
+
+float AudioEngine::getPatchRouting(int cueOutput, int deviceOutput) const
+{
+    if (!outputPatch) {
+        return 0.0f;
+    }
+    
+    return outputPatch->getPatchRouting(cueOutput, deviceOutput);
+}
+
+void AudioEngine::setPatchFusion(bool enabled)
+{
+    patchFusionEnabled.store(enabled);
+    refreshPatchFusion();
+}
+
+void AudioEngine::setBusMetering(bool enabled)
+{
+    busMeteringEnabled.store(enabled);
+    refreshPatchFusion();
+}
+
+void AudioEngine::refreshPatchFusion()
+{
+    // Fold the patch into the mixer's routes unless something needs the
+    // mixer outputs as real buffers between the two stages. Under cueMapLock,
+    // which configureChannels holds while it resizes the patch
+    juce::ScopedLock lock(cueMapLock);
+    if (patchFusionEnabled.load() && !busMeteringEnabled.load()) {
+        mixer->setFusedPatch(outputPatch->compileRoutes());
+    } else {
+        mixer->clearFusedPatch();
+    }
+}
+
+void AudioEngine::configureChannels(int numBuses, int numMixerOutputs, int numDeviceOutputs)
+{
+    // Called while our callback is not registered, so nothing is mixing
+    juce::ScopedLock lock(cueMapLock);
+    
+    numBuses = juce::jlimit(1, MatrixMixer::MAX_CHANNELS, numBuses);
+    numMixerOutputs = juce::jlimit(1, MatrixMixer::MAX_CHANNELS, numMixerOutputs);
+    numDeviceOutputs = juce::jlimit(1, OutputPatch::MAX_CHANNELS, numDeviceOutputs);
+    
+    mixer->configure(numBuses, numMixerOutputs, numDeviceOutputs);
+    outputPatch->configure(numMixerOutputs, numDeviceOutputs);
+    for (auto& pair : audioCues) {
+        pair.second->getMatrix().configure(numBuses);
+    }
+    
+    numBusChannels.store(numBuses);
+    numMixerOutputChannels.store(numMixerOutputs);
+    refreshPatchFusion();
+}
+
+void AudioEngine::initializeAudioFormats()
+{
+    if (!formatManager) {
+        return;
+    }
+    
+    // Register basic audio formats
+    formatManager->registerBasicFormats();
+}
+
+void AudioEngine::setupAudioDevice()
+{
+    // Implementation placeholder for device setup
+}
+
+void AudioEngine::processAudioBlock(const CueSnapshot* snapshot, float* const* outputChannelData,
+                                    int numOutputChannels, int numSamples, juce::int64 stageStart)
+{
+    // Ensure buffers are the right size
+    mixBuffer.setSize(numBusChannels.load(), numSamples, false, false, true);
+    tempBuffer.setSize(numMixerOutputChannels.load(), numSamples, false, false, true);
+    
+    // Clear mix buffer
+    mixBuffer.clear();
+    
+    // Process all active cues; each one adds itself onto the matrix inputs
+    const juce::int64 blockStart = samplePosition.load();
+    if (snapshot != nullptr) {
+        int numActive = 0;
+        for (auto* cue : snapshot->cues) {
+            numActive += cue->isPlaying() ? 1 : 0;
+        }
+        
+        RenderPool* pool = snapshot->renderPool;
+        const bool parallel = pool != nullptr
+                           && numActive >= MIN_PARALLEL_VOICES
+                           && !workerBuses.empty()
+                           && numSamples <= workerBuses.front().getNumSamples();
+        
+        if (parallel) {
+            renderContext.snapshot = snapshot;
+            renderContext.numSamples = numSamples;
+            renderContext.blockStart = blockStart;
+            pool->run(static_cast<int>(snapshot->cues.size()), &AudioEngine::renderVoice, this);
+            
+            // Join: fold the other workers' buses into the mix
+            for (size_t worker = 0; worker < workerBuses.size(); ++worker) {
+                if (workerBusUsed[worker] != 0) {
+                    for (int ch = 0; ch < mixBuffer.getNumChannels(); ++ch) {
+                        mixBuffer.addFrom(ch, 0, workerBuses[worker], ch, 0, numSamples);
+                    }
+                    workerBusUsed[worker] = 0;
+                }
+            }
+        } else {
+            // Light blocks are cheaper on one thread than waking the pool
+            for (auto* cue : snapshot->cues) {
+                if (cue->isPlaying()) {
+                    cue->processAudioBlock(mixBuffer, numSamples, blockStart);
+                }
+            }
+        }
+    }
+    
+    stageStart = recordStageTime(TimingStage::cueRender, stageStart);
+    
+    // Process through matrix mixer; with the patch fused in this writes the
+    // device outputs directly and the second pass is skipped
+    const float* const* mixInputs = mixBuffer.getArrayOfReadPointers();
+    float* const* mixOutputs = tempBuffer.getArrayOfWritePointers();
+    
+    const bool fused = mixer->processAudioBlock(mixInputs, mixOutputs, 
+                                                mixBuffer.getNumChannels(), 
+                                                tempBuffer.getNumChannels(), 
+                                                numSamples,
+                                                outputChannelData,
+                                                numOutputChannels);
+    stageStart = recordStageTime(TimingStage::mixer, stageStart);
+    
+    if (fused) {
+        outputPatch->meterDeviceOutputs(outputChannelData, numOutputChannels, numSamples);
+        recordStageTime(TimingStage::outputPatch, stageStart);
+        return;
+    }
+    
+    // Process through output patch
+    outputPatch->processAudioBlock(tempBuffer.getArrayOfReadPointers(),
+                                 outputChannelData,
+                                 tempBuffer.getNumChannels(),
+                                 numOutputChannels,
+                                 numSamples);
+    recordStageTime(TimingStage::outputPatch, stageStart);
+}
+
+bool AudioEngine::evictPreloadsFor(size_t requiredBytes)
+{
+    const size_t budget = preloadBudget.load();
+    if (requiredBytes > budget) {
+        return false;
+    }
+    
+    // Walk from the least recently used end, skipping cues playing from RAM
+    auto it = preloadLru.end();
+    while (preloadedBytes.load() + requiredBytes > budget && it != preloadLru.begin()) {
+        --it;
+        
+        auto cueIt = audioCues.find(*it);
+        if (cueIt == audioCues.end() || releaseCuePreload(cueIt->second.get())) {
+            it = preloadLru.erase(it);
+            updatePreloadUsage();
+        }
+    }
+    
+    return preloadedBytes.load() + requiredBytes <= budget;
+}
+
+void AudioEngine::touchPreload(const juce::String& cueId)
+{
+    preloadLru.remove(cueId);
+    preloadLru.push_front(cueId);
+}
+
+void AudioEngine::updatePreloadUsage()
+{
+    size_t total = 0;
+    int count = 0;
+    std::set<const SampleCache::SampleBuffer*> countedBuffers;
+    
+    for (const auto& cueId : preloadLru) {
+        auto it = audioCues.find(cueId);
+        if (it != audioCues.end() && it->second->isPreloaded()) {
+            // Cues sharing one decoded file only cost its memory once
+            if (countedBuffers.insert(it->second->getPreloadedAudio().get()).second) {
+                total += it->second->getPreloadedBytes();
+            }
+            ++count;
+        }
+    }
+    
+    sampleCache->purge();
+    
+    preloadedBytes.store(total);
+    numPreloadedCues.store(count);
+}
+
+AudioEngine::CueSnapshot* AudioEngine::acquireCueSnapshot()
+{
+    // Announce the snapshot we are about to walk, re-checking that it is
+    // still current so the control thread can never free it underneath us
+    CueSnapshot* snapshot = publishedSnapshot.load();
+    for (;;) {
+        audioThreadSnapshot.store(snapshot);
+        CueSnapshot* latest = publishedSnapshot.load();
+        if (latest == snapshot) {
+            return snapshot;
+        }
+        snapshot = latest;
+    }
+}
+
+void AudioEngine::beginTransaction()
+{
+    juce::ScopedLock lock(cueMapLock);
+    mixer->beginUpdate();
+    mixer->captureControls(transactionControls);
+    transactionStart = transportQueued;
+    transportHeld = true;
+}
+
+void AudioEngine::commitTransaction()
+{
+    juce::ScopedLock lock(cueMapLock);
+    
+    // Routes and cue matrices first, so they are in place by the block that
+    // applies the transport
+    mixer->endUpdate();
+    publishCueChanges();
+    transportHeld = false;
+    transportReleased.store(transportQueued, std::memory_order_release);
+    
+    // Commands made while the device was stopped, in the order they were made
+    std::vector<TransportCommand> held;
+    held.swap(heldTransport);
+    for (const auto& command : held) {
+        dispatchTransport(command);
+    }
+}
+
+void AudioEngine::abortTransaction()
+{
+    juce::ScopedLock lock(cueMapLock);
+    
+    // The restored matrix is published by the endUpdate() closing the
+    // transaction, so the audio thread never sees the abandoned routes
+    mixer->restoreControls(transactionControls);
+    mixer->endUpdate();
+    stagedCueChanges.reset();
+    heldTransport.clear();
+    transportHeld = false;
+    
+    if (transactionStart < transportQueued) {
+        transportSkipFrom.store(transactionStart);
+        transportSkipTo.store(transportQueued);
+        drainTransport();
+    }
+}
+
+bool AudioEngine::isTransportSkipped(juce::int64 index) const
+{
+    return index >= transportSkipFrom.load(std::memory_order_relaxed)
+        && index < transportSkipTo.load(std::memory_order_relaxed);
+}
+
+void AudioEngine::drainTransport()
+{
+    // Called with cueMapLock held: releases everything queued and returns once
+    // it has been consumed, by the audio thread or, if the device stops
+    // underneath us while its stopRendering() waits for our lock, here
+    transportReleased.store(transportQueued, std::memory_order_release);
+    while (!transportQueue->isEmpty() || pendingCueChanges.load() != nullptr) {
+        if (!deviceRunning.load()) {
+            applyQueuedTransport();
+            break;
+        }
+        std::this_thread::yield();
+    }
+}
+
+void AudioEngine::writeCueMatrix(const CueMatrixChange& change)
+{
+    // Called with cueMapLock held; inside a transaction the write waits for commit
+    if (transportHeld) {
+        if (!stagedCueChanges) {
+            stagedCueChanges = std::make_unique<CueMatrixChanges>();
+        }
+        stagedCueChanges->changes.push_back(change);
+        return;
+    }
+    
+    applyCueMatrixChange(change);
+}
+
+void AudioEngine::publishCueChanges()
+{
+    // Called with cueMapLock held
+    reclaimCueChanges();
+    if (!stagedCueChanges) {
+        return;
+    }
+    
+    if (!deviceRunning.load()) {
+        for (const auto& change : stagedCueChanges->changes) {
+            applyCueMatrixChange(change);
+        }
+        stagedCueChanges.reset();
+        return;
+    }
+    
+    // A previous commit the audio thread has not taken yet goes out with this
+    // one: no block has run since, so its transport is still queued as well
+    if (auto* unsent = pendingCueChanges.exchange(nullptr)) {
+        auto& changes = stagedCueChanges->changes;
+        changes.insert(changes.begin(), unsent->changes.begin(), unsent->changes.end());
+    }
+    
+    stagedCueChanges->releaseAt = transportQueued;
+    stagedCueChanges->sequence = ++nextCueChangeSequence;
+    pendingCueChanges.store(stagedCueChanges.get(), std::memory_order_release);
+    sentCueChanges.push_back(std::move(stagedCueChanges));
+}
+
+void AudioEngine::applyPendingCueChanges(juce::int64 released)
+{
+    // Only on the block that releases the matching transport. The control side
+    // frees a batch once appliedCueChanges passes it, which this thread does
+    // later, so peeking at one it then loses to a merge is safe.
+    CueMatrixChanges* pending = pendingCueChanges.load(std::memory_order_acquire);
+    if (pending == nullptr || pending->releaseAt > released
+        || !pendingCueChanges.compare_exchange_strong(pending, nullptr)) {
+        return;
+    }
+    
+    for (const auto& change : pending->changes) {
+        applyCueMatrixChange(change);
+    }
+    appliedCueChanges.store(pending->sequence, std::memory_order_release);
+}
+
+void AudioEngine::reclaimCueChanges()
+{
+    const juce::int64 applied = appliedCueChanges.load(std::memory_order_acquire);
+    
+    sentCueChanges.erase(std::remove_if(sentCueChanges.begin(), sentCueChanges.end(),
+                                        [applied](const std::unique_ptr<CueMatrixChanges>& changes) {
+                                            return changes->sequence <= applied;
+                                        }),
+                         sentCueChanges.end());
+}
+
+void AudioEngine::applyCueMatrixChange(const CueMatrixChange& change)
+{
+    auto& matrix = change.cue->getMatrix();
+    switch (change.type) {
+        case CueMatrixChange::Type::crosspoint:
+            matrix.setCrosspoint(change.channel, change.output, change.level, change.muted);
+            break;
+            
+        case CueMatrixChange::Type::inputLevel:
+            matrix.setInputLevel(change.channel, change.level, change.muted);
+            break;
+            
+        case CueMatrixChange::Type::outputLevel:
+            matrix.setOutputLevel(change.output, change.level, change.muted);
+            break;
+    }
+}
+
+bool AudioEngine::dispatchTransport(const TransportCommand& command)
+{
+    // Called with cueMapLock held, which makes this the single producer
+    if (deviceRunning.load()) {
+        // Seek an idle stream here rather than on the audio thread, so the
+        // worker refills it while the command waits to be applied
+        if (command.type == TransportCommand::Type::play && command.startTime > 0.0) {
+            command.cue->cueStream(command.startTime);
+        }
+        
+        if (command.cue != nullptr) {
+            command.cue->transportQueued();
+        }
+        if (!transportQueue->push(command)) {
+            if (command.cue != nullptr) {
+                command.cue->transportApplied();
+            }
+            return false;
+        }
+        
+        ++transportQueued;
+        if (!transportHeld) {
+            transportReleased.store(transportQueued, std::memory_order_release);
+        }
+        return true;
+    }
+    
+    // Nothing to wait behind while stopped, but a transaction keeps it until commit
+    if (transportHeld) {
+        heldTransport.push_back(command);
+        return true;
+    }
+    
+    applyTransportCommand(command, currentSnapshot.get());
+    return true;
+}
+
+void AudioEngine::applyTransportCommand(const TransportCommand& command, const CueSnapshot* snapshot)
+{
+    switch (command.type) {
+        case TransportCommand::Type::play:
+            command.cue->play(command.startTime, command.fadeTime, command.startSample, command.fadeCurve);
+            break;
+            
+        case TransportCommand::Type::stop:
+            command.cue->stop(command.fadeTime, command.fadeCurve);
+            break;
+            
+        case TransportCommand::Type::pause:
+            command.cue->pause();
+            break;
+            
+        case TransportCommand::Type::resume:
+            command.cue->resume();
+            break;
+            
+        case TransportCommand::Type::go:
+            cueSequencer->go(command.cue, command.startSample);
+            break;
+            
+        case TransportCommand::Type::stopAll:
+            // Panic also cancels pending pre-waits and follow-ons
+            cueSequencer->clear();
+            if (snapshot != nullptr) {
+                for (auto* cue : snapshot->cues) {
+                    cue->stop(command.fadeTime, command.fadeCurve);
+                }
+            }
+            break;
+    }
+}
+
+void AudioEngine::publishCueSnapshot(const AudioCue* excludedCue)
+{
+    // Called with cueMapLock held
+    auto snapshot = std::make_unique<CueSnapshot>();
+    snapshot->cues.reserve(audioCues.size());
+    for (auto& pair : audioCues) {
+        if (pair.second.get() != excludedCue) {
+            snapshot->cues.push_back(pair.second.get());
+        }
+    }
+    
+    snapshot->sequence = cueSequencer->buildGraph(audioCues, excludedCue);
+    snapshot->renderPool = renderPool.get();
+    
+    publishedSnapshot.store(snapshot.get());
+    if (currentSnapshot) {
+        retiredSnapshots.push_back(std::move(currentSnapshot));
+    }
+    currentSnapshot = std::move(snapshot);
+    
+    reclaimSnapshots();
+}
+
+void AudioEngine::detachCue(const AudioCue* cue)
+{
+    // Let queued transport commands land first, then publish a list without
+    // the cue and wait until the audio thread has finished any block that
+    // could still be using it. An open transaction has to give up what it has
+    // queued so far, or the queue would never drain; commands that only load
+    // or preload cues, which get here, are not allowed in a batch for that reason.
+    drainTransport();
+    
+    publishCueSnapshot(cue);
+    waitForAudioThread();
+}
+
+void AudioEngine::waitForAudioThread()
+{
+    // Returns once the audio thread holds no snapshot older than the current one
+    while (!retiredSnapshots.empty()) {
+        std::this_thread::yield();
+        reclaimSnapshots();
+    }
+}
+
+void AudioEngine::prepareWorkerBuses(int blockSize)
+{
+    // Called with cueMapLock held while the audio thread cannot use the buses
+    const int numExtraWorkers = renderPool ? renderPool->getNumWorkers() - 1 : 0;
+    
+    workerBuses.resize(static_cast<size_t>(numExtraWorkers));
+    workerBusUsed.assign(static_cast<size_t>(numExtraWorkers), 0);
+    for (auto& bus : workerBuses) {
+        bus.setSize(numBusChannels.load(), juce::jmax(1, blockSize));
+    }
+}
+
+void AudioEngine::renderVoice(void* context, int jobIndex, int workerIndex)
+{
+    auto& engine = *static_cast<AudioEngine*>(context);
+    const auto& job = engine.renderContext;
+    
+    AudioCue* cue = job.snapshot->cues[static_cast<size_t>(jobIndex)];
+    if (!cue->isPlaying()) {
+        return;
+    }
+    const TraceRecorder::Scope trace("render", "voice", jobIndex);
+    
+    // The device thread owns mixBuffer; other workers use their own bus,
+    // cleared the first time it is touched in a block
+    if (workerIndex == 0) {
+        cue->processAudioBlock(engine.mixBuffer, job.numSamples, job.blockStart);
+        return;
+    }
+    
+    const auto busIndex = static_cast<size_t>(workerIndex - 1);
+    auto& bus = engine.workerBuses[busIndex];
+    if (engine.workerBusUsed[busIndex] == 0) {
+        bus.clear(0, job.numSamples);
+        engine.workerBusUsed[busIndex] = 1;
+    }
+    cue->processAudioBlock(bus, job.numSamples, job.blockStart);
+}
+
+void AudioEngine::reclaimSnapshots()
+{
+    CueSnapshot* inUse = audioThreadSnapshot.load();
+    
+    retiredSnapshots.erase(std::remove_if(retiredSnapshots.begin(), retiredSnapshots.end(),
+                                          [inUse](const std::unique_ptr<CueSnapshot>& snapshot) {
+                                              return snapshot.get() != inUse;
+                                          }),
+                           retiredSnapshots.end());
+}
+
+bool AudioEngine::releaseCuePreload(AudioCue* cue)
+{
+    if (cue->isPlaying()) {
+        return cue->releasePreload(); // Refuses while playing from RAM
+    }
+    
+    // The shared buffer may be freed, so keep the audio thread off the cue
+    detachCue(cue);
+    const bool released = cue->releasePreload();
+    publishCueSnapshot();
+    return released;
+}
+
+void AudioEngine::reportVoiceChanges(const CueSnapshot* snapshot, juce::int64 blockEndSample)
+{
+    // Audio thread: completions and finished fade-ins for every voice, whether
+    // it was started by the sequencer, a play command or a batch
+    if (snapshot == nullptr) {
+        return;
+    }
+    
+    for (auto* cue : snapshot->cues) {
+        const int changes = cue->takeVoiceChanges();
+        if ((changes & AudioCue::voiceEnded) != 0) {
+            cueSequencer->pushEvent(SequencerEvent::Type::cueCompleted, cue, blockEndSample);
+        }
+        if ((changes & AudioCue::fadeFinished) != 0) {
+            cueSequencer->pushEvent(SequencerEvent::Type::fadeCompleted, cue, blockEndSample);
+        }
+    }
+}
+
+void AudioEngine::deliverEvents()
+{
+    SequencerEvent event;
+    while (cueSequencer->popEvent(event)) {
+        juce::DynamicObject::Ptr data = new juce::DynamicObject();
+        data->setProperty("cueId", event.cue->getId());
+        data->setProperty("samplePosition", event.samplePosition);
+        
+        juce::String name;
+        switch (event.type) {
+            case SequencerEvent::Type::cueStarted:
+                name = "cueStarted";
+                break;
+            case SequencerEvent::Type::cueCompleted:
+                name = "cueCompleted";
+                break;
+            case SequencerEvent::Type::fadeCompleted:
+                name = "fadeCompleted";
+                break;
+        }
+        postEvent(name, juce::var(data.get()));
+    }
+    
+    // Dropouts are counted on the audio thread and reported from here
+    const int dropouts = dropoutCount.load();
+    if (dropouts != reportedDropouts) {
+        reportedDropouts = dropouts;
+        
+        juce::DynamicObject::Ptr data = new juce::DynamicObject();
+        data->setProperty("dropoutCount", dropouts);
+        data->setProperty("overrunCount", overrunCount.load());
+        data->setProperty("lateCallbackCount", lateCallbackCount.load());
+        data->setProperty("peakCpuUsage", peakCpuUsage.load());
+        data->setProperty("samplePosition", samplePosition.load());
+        postEvent("audioDropout", juce::var(data.get()));
+    }
+}
+
+void AudioEngine::postEvent(const juce::String& name, const juce::var& data)
+{
+    juce::ScopedLock lock(eventLock);
+    if (eventCallback) {
+        eventCallback(name, data);
+    }
+}
+
+AudioEngine::EventThread::EventThread(AudioEngine& owner)
+    : juce::Thread("CueForge Events")
+    , engine(owner)
+{
+}
+
+AudioEngine::EventThread::~EventThread()
+{
+    stopThread(2000);
+}
+
+void AudioEngine::EventThread::run()
+{
+    while (!threadShouldExit()) {
+        engine.deliverEvents();
+        engine.mixer->commitPostedChanges();
+        wait(5);
+    }
+}
+
+bool AudioEngine::startOfflineRender(const OfflineRenderSettings& settings)
+{
+    if (initialized.load() || isOfflineRendering()) {
+        return false;
+    }
+    
+    if (settings.sampleRate <= 0.0 || settings.blockSize <= 0 || settings.outputFile == juce::File()
+        || formatManager->findFormatForFileExtension(settings.outputFile.getFileExtension()) == nullptr) {
+        return false;
+    }
+    
+    offlineRenderer = std::make_unique<OfflineRenderThread>(*this, settings);
+    offlineRenderer->startThread();
+    return true;
+}
+
+void AudioEngine::cancelOfflineRender()
+{
+    // The thread finishes the file it has written so far
+    offlineRenderer.reset();
+}
+
+AudioEngine::OfflineRenderThread::OfflineRenderThread(AudioEngine& owner, const OfflineRenderSettings& renderSettings)
+    : juce::Thread("CueForge Offline Render")
+    , engine(owner)
+    , settings(renderSettings)
+{
+}
+
+AudioEngine::OfflineRenderThread::~OfflineRenderThread()
+{
+    stopThread(10000);
+}
+
+void AudioEngine::OfflineRenderThread::run()
+{
+    const juce::String error = render();
+    
+    juce::DynamicObject::Ptr data = new juce::DynamicObject();
+    data->setProperty("file", settings.outputFile.getFullPathName());
+    data->setProperty("renderedSeconds", renderedSeconds.load());
+    data->setProperty("cancelled", threadShouldExit());
+    
+    if (error.isNotEmpty()) {
+        data->setProperty("error", error);
+    }
+    engine.postEvent(error.isEmpty() ? "offlineRenderComplete" : "offlineRenderFailed", juce::var(data.get()));
+}
+
+juce::String AudioEngine::OfflineRenderThread::render()
+{
+    auto* format = engine.formatManager->findFormatForFileExtension(settings.outputFile.getFileExtension());
+    const int numChannels = engine.outputPatch->getNumDeviceOutputs();
+    
+    settings.outputFile.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream>(settings.outputFile);
+    if (format == nullptr || !stream->openedOk()) {
+        return "Cannot write " + settings.outputFile.getFullPathName();
+    }
+    
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), settings.sampleRate,
+                                                                            static_cast<unsigned int>(numChannels),
+                                                                            settings.bitDepth, {}, 0));
+    if (writer == nullptr) {
+        return format->getFormatName() + " cannot write " + juce::String(numChannels) + " channels at "
+             + juce::String(settings.bitDepth) + " bits";
+    }
+    stream.release(); // Owned by the writer now
+    
+    // Voice threads change while nothing is rendering
+    const int previousThreads = engine.getRenderThreads();
+    const int renderThreads = settings.renderThreads >= 0
+                            ? settings.renderThreads
+                            : juce::SystemStats::getNumCpus() - 1;
+    engine.setRenderThreads(juce::jlimit(0, RenderPool::MAX_WORKERS - 1, renderThreads));
+    
+    engine.prepareToRender(settings.sampleRate, settings.blockSize, false);
+    if (settings.goCueId.isNotEmpty()) {
+        engine.goCue(settings.goCueId);
+    }
+    
+    juce::AudioBuffer<float> block(numChannels, settings.blockSize);
+    const auto maxSamples = static_cast<juce::int64>((settings.durationSeconds > 0.0 ? settings.durationSeconds
+                                                                                      : MAX_OFFLINE_RENDER_SECONDS)
+                                                     * settings.sampleRate);
+    const auto tailSamples = static_cast<juce::int64>(settings.tailSeconds * settings.sampleRate);
+    juce::int64 rendered = 0;
+    juce::int64 endSample = -1;
+    juce::String error;
+    
+    while (!threadShouldExit() && rendered < maxSamples && (endSample < 0 || rendered < endSample)) {
+        const int numSamples = static_cast<int>(juce::jmin<juce::int64>(settings.blockSize, maxSamples - rendered));
+        
+        if (!waitForStreams(numSamples)) {
+            break;
+        }
+        
+        engine.audioDeviceIOCallback(nullptr, 0, block.getArrayOfWritePointers(), numChannels, numSamples);
+        if (!writer->writeFromAudioSampleBuffer(block, 0, numSamples)) {
+            error = "Write failed";
+            break;
+        }
+        
+        rendered += numSamples;
+        renderedSeconds.store(static_cast<double>(rendered) / settings.sampleRate);
+        
+        // Without a fixed length, stop a tail after the show goes quiet
+        if (settings.durationSeconds <= 0.0 && endSample < 0 && isFinished()) {
+            endSample = rendered + tailSamples;
+        }
+    }
+    
+    engine.stopRendering();
+    engine.setRenderThreads(previousThreads);
+    return error;
+}
+
+bool AudioEngine::OfflineRenderThread::waitForStreams(int numSamples)
+{
+    // Faster than realtime can outrun the disk threads, so give them time to
+    // catch up instead of rendering underruns
+    const auto deadline = juce::Time::getMillisecondCounter() + 5000;
+    
+    while (!threadShouldExit()) {
+        bool ready = true;
+        {
+            juce::ScopedLock lock(engine.cueMapLock);
+            for (const auto& pair : engine.audioCues) {
+                ready = ready && pair.second->isStreamReady(numSamples);
+            }
+        }
+        
+        // A stream that never fills (read errors) underruns as it would live
+        if (ready || juce::Time::getMillisecondCounter() > deadline) {
+            return true;
+        }
+        
+        engine.diskStreamer->wakeUp();
+        wait(1);
+    }
+    return false;
+}
+
+bool AudioEngine::OfflineRenderThread::isFinished()
+{
+    // This thread is the audio thread, so the sequencer state is ours to read
+    if (!engine.cueSequencer->isIdle() || !engine.transportQueue->isEmpty()) {
+        return false;
+    }
+    
+    juce::ScopedLock lock(engine.cueMapLock);
+    for (const auto& pair : engine.audioCues) {
+        if (pair.second->isPlaying() || pair.second->isScheduled()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void AudioEngine::updatePerformanceMetrics(juce::int64 startTicks, int numSamples)
+{
+    const juce::int64 endTicks = juce::Time::getHighResolutionTicks();
+    const double sampleRate = currentSampleRate.load();
+    if (numSamples <= 0 || sampleRate <= 0.0) {
+        return;
+    }
+    
+    const double blockSeconds = numSamples / sampleRate;
+    const double callbackSeconds = juce::Time::highResolutionTicksToSeconds(endTicks - startTicks);
+    timingHistograms[static_cast<size_t>(TimingStage::callback)].record(static_cast<juce::int64>(callbackSeconds * 1.0e9));
+    const double load = 100.0 * callbackSeconds / blockSeconds;
+    
+    const double coefficient = std::exp(-blockSeconds / LOAD_AVERAGE_SECONDS);
+    cpuUsage.store(coefficient * cpuUsage.load() + (1.0 - coefficient) * load);
+    lastCallbackMs.store(callbackSeconds * 1000.0);
+    
+    auto& timing = callbackTiming;
+    timing.windowPeak = juce::jmax(timing.windowPeak, load);
+    timing.windowSeconds += blockSeconds;
+    if (timing.windowSeconds >= LOAD_WINDOW_SECONDS) {
+        peakCpuUsage.store(timing.windowPeak);
+        timing.windowPeak = 0.0;
+        timing.windowSeconds = 0.0;
+    }
+    
+    if (TraceRecorder::isRecording()) {
+        auto& trace = TraceRecorder::getInstance();
+        trace.setThreadName("Audio Device");
+        trace.addSpan("audio", "callback", startTicks, endTicks, numSamples);
+    }
+    
+    // An offline render waits on disk between blocks and has no deadline
+    if (!timing.realtime) {
+        return;
+    }
+    
+    const bool overran = callbackSeconds > blockSeconds;
+    
+    // Callbacks are due one period apart from the first. Drivers that deliver
+    // blocks in bursts arrive early and are left alone; arriving more than
+    // LATE_CALLBACK_PERIODS behind schedule means the device ran dry. Any late
+    // arrival re-anchors the schedule, which also absorbs device clock drift
+    const auto periodTicks = static_cast<juce::int64>(blockSeconds * juce::Time::getHighResolutionTicksPerSecond());
+    bool late = false;
+    if (timing.expectedTicks != 0) {
+        const juce::int64 lateness = startTicks - timing.expectedTicks;
+        late = lateness > static_cast<juce::int64>(LATE_CALLBACK_PERIODS * periodTicks);
+        if (lateness > 0 || -lateness > 2 * periodTicks) {
+            timing.expectedTicks = startTicks;
+        }
+    } else {
+        timing.expectedTicks = startTicks;
+    }
+    timing.expectedTicks += periodTicks;
+    
+    if (!overran && !late) {
+        return;
+    }
+    
+    const int dropouts = dropoutCount.fetch_add(1) + 1;
+    if (overran) {
+        overrunCount.fetch_add(1);
+        TraceRecorder::getInstance().addInstant("audio", "overrun", dropouts);
+    }
+    if (late) {
+        lateCallbackCount.fetch_add(1);
+        TraceRecorder::getInstance().addInstant("audio", "lateCallback", dropouts);
+    }
+}
+
+juce::int64 AudioEngine::recordStageTime(TimingStage stage, juce::int64 startTicks)
+{
+    const juce::int64 now = juce::Time::getHighResolutionTicks();
+    const double seconds = juce::Time::highResolutionTicksToSeconds(now - startTicks);
+    timingHistograms[static_cast<size_t>(stage)].record(static_cast<juce::int64>(seconds * 1.0e9));
+    TraceRecorder::getInstance().addSpan("audio", getTimingStageName(stage), startTicks, now);
+    return now;
+}
+
+const char* AudioEngine::getTimingStageName(TimingStage stage)
+{
+    switch (stage) {
+        case TimingStage::callback:    return "callback";
+        case TimingStage::transport:   return "transport";
+        case TimingStage::cueRender:   return "cueRender";
+        case TimingStage::mixer:       return "mixer";
+        case TimingStage::outputPatch: return "outputPatch";
+    }
+    return "";
+}
+
+const LatencyHistogram& AudioEngine::getTimingHistogram(TimingStage stage) const
+{
+    return timingHistograms[static_cast<size_t>(stage)];
+}
+
+void AudioEngine::resetTimingHistograms()
+{
+    for (auto& histogram : timingHistograms) {
+        histogram.reset();
+    }
 }
\ No newline at end of file
@@ -1,14 +1,28 @@
 #include "../include/CommandProcessor.h"
 #include "../include/AudioEngine.h"
+#include "../include/CueMatrix.h"
+#include "../include/TraceRecorder.h"
+
+#include <cmath>
 
 CommandProcessor::CommandProcessor(AudioEngine* engine)
     : audioEngine(engine)
 {
     registerBuiltInCommands();
+    
+    // Sequencer events from the engine go out through our own event callback
+    if (audioEngine) {
+        audioEngine->setEventCallback([this](const juce::String& event, const juce::var& data) {
+            sendEvent(event, data);
+        });
+    }
 }
 
 CommandProcessor::~CommandProcessor()
 {
+    if (audioEngine) {
+        audioEngine->setEventCallback(nullptr);
+    }
 }
 
 juce::var CommandProcessor::processCommand(const juce::String& jsonCommand)
@@ -39,6 +53,11 @@ juce::var CommandProcessor::processCommand(const juce::var& command)
     }
     
     try {
+        // The map key outlives the trace, so its characters can name the span
+        if (TraceRecorder::isRecording()) {
+            TraceRecorder::getInstance().setThreadName("Commands");
+        }
+        const TraceRecorder::Scope trace("command", it->first.toRawUTF8());
         juce::var params = command.getProperty("params", juce::var());
         return it->second(params);
     }
@@ -60,9 +79,11 @@ void CommandProcessor::sendEvent(const juce::String& eventType, const juce::var&
 }
 
 void CommandProcessor::registerCommand(const juce::String& commandName, 
-                                     std::function<juce::var(const juce::var&)> handler)
+                                     std::function<juce::var(const juce::var&)> handler,
+                                     const juce::StringArray& requiredParams)
 {
     commandHandlers[commandName] = handler;
+    commandParameters[commandName] = requiredParams;
 }
 
 void CommandProcessor::registerBuiltInCommands()
@@ -71,29 +92,51 @@ void CommandProcessor::registerBuiltInCommands()
     registerCommand("initialize", [this](const juce::var& params) { return handleInitialize(params); });
     registerCommand("shutdown", [this](const juce::var& params) { return handleShutdown(params); });
     registerCommand("getStatus", [this](const juce::var& params) { return handleGetStatus(params); });
-    registerCommand("setAudioDevice", [this](const juce::var& params) { return handleSetAudioDevice(params); });
+    registerCommand("getMeters", [this](const juce::var& params) { return handleGetMeters(params); });
+    registerCommand("getTimingStats", [this](const juce::var& params) { return handleGetTimingStats(params); });
+    registerCommand("resetTimingStats", [this](const juce::var& params) { return handleResetTimingStats(params); });
+    registerCommand("startTrace", [this](const juce::var& params) { return handleStartTrace(params); });
+    registerCommand("stopTrace", [this](const juce::var& params) { return handleStopTrace(params); });
+    registerCommand("writeTrace", [this](const juce::var& params) { return handleWriteTrace(params); }, {"outputFile"});
+    registerCommand("setAudioDevice", [this](const juce::var& params) { return handleSetAudioDevice(params); }, {"deviceName"});
     registerCommand("getDevices", [this](const juce::var& params) { return handleGetDevices(params); });
+    registerCommand("batch", [this](const juce::var& params) { return handleBatch(params); }, {"commands"});
     
     // Audio cue commands
-    registerCommand("createCue", [this](const juce::var& params) { return handleCreateCue(params); });
-    registerCommand("loadFile", [this](const juce::var& params) { return handleLoadFile(params); });
-    registerCommand("playCue", [this](const juce::var& params) { return handlePlayCue(params); });
-    registerCommand("stopCue", [this](const juce::var& params) { return handleStopCue(params); });
-    registerCommand("pauseCue", [this](const juce::var& params) { return handlePauseCue(params); });
-    registerCommand("resumeCue", [this](const juce::var& params) { return handleResumeCue(params); });
+    registerCommand("createCue", [this](const juce::var& params) { return handleCreateCue(params); }, {"cueId", "filePath"});
+    registerCommand("loadFile", [this](const juce::var& params) { return handleLoadFile(params); }, {"cueId", "filePath"});
+    registerCommand("playCue", [this](const juce::var& params) { return handlePlayCue(params); }, {"cueId"});
+    registerCommand("stopCue", [this](const juce::var& params) { return handleStopCue(params); }, {"cueId"});
+    registerCommand("pauseCue", [this](const juce::var& params) { return handlePauseCue(params); }, {"cueId"});
+    registerCommand("resumeCue", [this](const juce::var& params) { return handleResumeCue(params); }, {"cueId"});
     registerCommand("stopAllCues", [this](const juce::var& params) { return handleStopAllCues(params); });
+    registerCommand("playCueAt", [this](const juce::var& params) { return handlePlayCueAt(params); }, {"cueId"});
+    registerCommand("getClock", [this](const juce::var& params) { return handleGetClock(params); });
+    registerCommand("setCueTiming", [this](const juce::var& params) { return handleSetCueTiming(params); }, {"cueId"});
+    registerCommand("goCue", [this](const juce::var& params) { return handleGoCue(params); }, {"cueId"});
+    registerCommand("setCuePreload", [this](const juce::var& params) { return handleSetCuePreload(params); }, {"cueId", "preload"});
+    registerCommand("setPreloadBudget", [this](const juce::var& params) { return handleSetPreloadBudget(params); }, {"budgetBytes"});
+    registerCommand("setRenderThreads", [this](const juce::var& params) { return handleSetRenderThreads(params); }, {"numThreads"});
+    registerCommand("renderOffline", [this](const juce::var& params) { return handleRenderOffline(params); }, {"outputFile"});
+    registerCommand("cancelOfflineRender", [this](const juce::var& params) { return handleCancelOfflineRender(params); });
     
     // Matrix commands
-    registerCommand("setCrosspoint", [this](const juce::var& params) { return handleSetCrosspoint(params); });
-    registerCommand("getCrosspoint", [this](const juce::var& params) { return handleGetCrosspoint(params); });
-    registerCommand("setInputLevel", [this](const juce::var& params) { return handleSetInputLevel(params); });
-    registerCommand("setOutputLevel", [this](const juce::var& params) { return handleSetOutputLevel(params); });
-    registerCommand("muteOutput", [this](const juce::var& params) { return handleMuteOutput(params); });
-    registerCommand("soloOutput", [this](const juce::var& params) { return handleSoloOutput(params); });
+    registerCommand("setCrosspoint", [this](const juce::var& params) { return handleSetCrosspoint(params); }, {"cueId", "input", "output", "level"});
+    registerCommand("getCrosspoint", [this](const juce::var& params) { return handleGetCrosspoint(params); }, {"cueId", "input", "output"});
+    registerCommand("setInputLevel", [this](const juce::var& params) { return handleSetInputLevel(params); }, {"cueId", "input", "level"});
+    registerCommand("setCueInputLevel", [this](const juce::var& params) { return handleSetInputLevel(params); }, {"cueId", "input", "level"});
+    registerCommand("setCueOutputLevel", [this](const juce::var& params) { return handleSetCueOutputLevel(params); }, {"cueId", "output", "level"});
+    registerCommand("setCueMatrixRouting", [this](const juce::var& params) { return handleSetCueMatrixRouting(params); }, {"cueId", "matrix"});
+    registerCommand("setOutputLevel", [this](const juce::var& params) { return handleSetOutputLevel(params); }, {"output", "level"});
+    registerCommand("muteOutput", [this](const juce::var& params) { return handleMuteOutput(params); }, {"output", "mute"});
+    registerCommand("soloOutput", [this](const juce::var& params) { return handleSoloOutput(params); }, {"output", "solo"});
+    registerCommand("setGainRampTime", [this](const juce::var& params) { return handleSetGainRampTime(params); }, {"seconds"});
     
     // Patch commands
-    registerCommand("setPatchRouting", [this](const juce::var& params) { return handleSetPatchRouting(params); });
-    registerCommand("getPatchRouting", [this](const juce::var& params) { return handleGetPatchRouting(params); });
+    registerCommand("setPatchRouting", [this](const juce::var& params) { return handleSetPatchRouting(params); }, {"cueOutput", "deviceOutput", "level"});
+    registerCommand("getPatchRouting", [this](const juce::var& params) { return handleGetPatchRouting(params); }, {"cueOutput", "deviceOutput"});
+    registerCommand("setPatchFusion", [this](const juce::var& params) { return handleSetPatchFusion(params); }, {"enabled"});
+    registerCommand("setBusMetering", [this](const juce::var& params) { return handleSetBusMetering(params); }, {"enabled"});
 }
 
 juce::var CommandProcessor::handleInitialize(const juce::var& params)
@@ -102,7 +145,25 @@ juce::var CommandProcessor::handleInitialize(const juce::var& params)
         return createErrorResponse("AudioEngine not available");
     }
     
-    bool success = audioEngine->initialize();
+    // Optional channel layout for large rigs; defaults match the old fixed sizes
+    int outputChannels = params.getProperty("outputChannels", AudioEngine::DEFAULT_DEVICE_OUTPUTS);
+    int buses = params.getProperty("buses", MatrixMixer::DEFAULT_INPUTS);
+    int mixerOutputs = params.getProperty("mixerOutputs", MatrixMixer::DEFAULT_OUTPUTS);
+    
+    // virtualDevice: { sampleRate, bufferSize, jitterMs } runs without hardware
+    const juce::var virtualDevice = params.getProperty("virtualDevice", juce::var());
+    if (virtualDevice.isObject() || static_cast<bool>(virtualDevice)) {
+        VirtualAudioDevice::Settings settings;
+        settings.sampleRate = virtualDevice.getProperty("sampleRate", settings.sampleRate);
+        settings.bufferSize = virtualDevice.getProperty("bufferSize", settings.bufferSize);
+        settings.jitterMs = virtualDevice.getProperty("jitterMs", settings.jitterMs);
+        settings.numOutputs = outputChannels;
+        
+        bool success = audioEngine->initializeVirtual(settings, buses, mixerOutputs);
+        return createSuccessResponse(juce::var(success));
+    }
+    
+    bool success = audioEngine->initialize(outputChannels, buses, mixerOutputs);
     return createSuccessResponse(juce::var(success));
 }
 
@@ -129,12 +190,169 @@ juce::var CommandProcessor::handleGetStatus(const juce::var& params)
     statusObj->setProperty("sampleRate", status.sampleRate);
     statusObj->setProperty("bufferSize", status.bufferSize);
     statusObj->setProperty("cpuUsage", status.cpuUsage);
+    statusObj->setProperty("peakCpuUsage", status.peakCpuUsage);
+    statusObj->setProperty("lastCallbackMs", status.lastCallbackMs);
     statusObj->setProperty("dropoutCount", status.dropoutCount);
+    statusObj->setProperty("overrunCount", status.overrunCount);
+    statusObj->setProperty("lateCallbackCount", status.lateCallbackCount);
+    statusObj->setProperty("diskUnderruns", status.diskUnderruns);
+    statusObj->setProperty("numDiskStreams", status.numDiskStreams);
     statusObj->setProperty("currentDevice", status.currentDevice);
+    statusObj->setProperty("preloadBudgetBytes", status.preloadBudgetBytes);
+    statusObj->setProperty("preloadedBytes", status.preloadedBytes);
+    statusObj->setProperty("numPreloadedCues", status.numPreloadedCues);
+    statusObj->setProperty("numSharedSamples", status.numSharedSamples);
+    statusObj->setProperty("sharedSampleBytes", status.sharedSampleBytes);
+    statusObj->setProperty("renderThreads", status.renderThreads);
+    statusObj->setProperty("patchFusionEnabled", status.patchFusionEnabled);
+    statusObj->setProperty("busMetering", status.busMetering);
+    statusObj->setProperty("patchFused", status.patchFused);
+    statusObj->setProperty("mixKernel", status.mixKernel);
+    statusObj->setProperty("numBuses", status.numBuses);
+    statusObj->setProperty("numMixerOutputs", status.numMixerOutputs);
+    statusObj->setProperty("numDeviceOutputs", status.numDeviceOutputs);
+    statusObj->setProperty("offlineRendering", status.offlineRendering);
+    statusObj->setProperty("offlineRenderedSeconds", status.offlineRenderedSeconds);
     
     return createSuccessResponse(juce::var(statusObj.get()));
 }
 
+juce::var CommandProcessor::handleGetMeters(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    auto meters = audioEngine->getMeters();
+    
+    // One object per stage with parallel per-channel arrays (linear gain)
+    auto makeSection = [](const std::vector<MeterBank::Level>& levels) {
+        juce::Array<juce::var> peak, rms, peakHold;
+        for (const auto& level : levels) {
+            peak.add(level.peak);
+            rms.add(level.rms);
+            peakHold.add(level.peakHold);
+        }
+        
+        juce::DynamicObject::Ptr section = new juce::DynamicObject();
+        section->setProperty("peak", peak);
+        section->setProperty("rms", rms);
+        section->setProperty("peakHold", peakHold);
+        return juce::var(section.get());
+    };
+    
+    juce::DynamicObject::Ptr metersObj = new juce::DynamicObject();
+    metersObj->setProperty("inputs", makeSection(meters.inputs));
+    metersObj->setProperty("outputs", makeSection(meters.outputs));
+    metersObj->setProperty("deviceOutputs", makeSection(meters.deviceOutputs));
+    
+    return createSuccessResponse(juce::var(metersObj.get()));
+}
+
+juce::var CommandProcessor::handleGetTimingStats(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    // Optional raw buckets ([lowerUs, upperUs, count] for each non-empty one)
+    const bool includeBuckets = params.getProperty("includeBuckets", false);
+    
+    juce::DynamicObject::Ptr stages = new juce::DynamicObject();
+    std::vector<juce::uint64> counts;
+    for (int index = 0; index < AudioEngine::NUM_TIMING_STAGES; ++index) {
+        const auto stage = static_cast<AudioEngine::TimingStage>(index);
+        const auto& histogram = audioEngine->getTimingHistogram(stage);
+        const auto summary = histogram.getSummary();
+        
+        juce::DynamicObject::Ptr stageObj = new juce::DynamicObject();
+        stageObj->setProperty("count", summary.count);
+        stageObj->setProperty("meanUs", summary.meanUs);
+        stageObj->setProperty("minUs", summary.minUs);
+        stageObj->setProperty("p50Us", summary.p50Us);
+        stageObj->setProperty("p90Us", summary.p90Us);
+        stageObj->setProperty("p99Us", summary.p99Us);
+        stageObj->setProperty("p999Us", summary.p999Us);
+        stageObj->setProperty("maxUs", summary.maxUs);
+        
+        if (includeBuckets) {
+            histogram.getCounts(counts);
+            juce::Array<juce::var> buckets;
+            for (int bucket = 0; bucket < static_cast<int>(counts.size()); ++bucket) {
+                if (counts[static_cast<size_t>(bucket)] != 0) {
+                    buckets.add(juce::Array<juce::var> {
+                        LatencyHistogram::getBucketLowerBound(bucket) / 1000.0,
+                        LatencyHistogram::getBucketUpperBound(bucket) / 1000.0,
+                        static_cast<juce::int64>(counts[static_cast<size_t>(bucket)])
+                    });
+                }
+            }
+            stageObj->setProperty("buckets", buckets);
+        }
+        
+        stages->setProperty(AudioEngine::getTimingStageName(stage), juce::var(stageObj.get()));
+    }
+    
+    juce::DynamicObject::Ptr result = new juce::DynamicObject();
+    result->setProperty("blockUs", audioEngine->getStatus().bufferSize * 1.0e6 / audioEngine->getSampleRate());
+    result->setProperty("stages", juce::var(stages.get()));
+    return createSuccessResponse(juce::var(result.get()));
+}
+
+juce::var CommandProcessor::handleResetTimingStats(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    audioEngine->resetTimingHistograms();
+    return createSuccessResponse();
+}
+
+juce::var CommandProcessor::handleStartTrace(const juce::var& params)
+{
+    TraceRecorder::getInstance().start();
+    return createSuccessResponse();
+}
+
+juce::var CommandProcessor::handleStopTrace(const juce::var& params)
+{
+    TraceRecorder::getInstance().stop();
+    return createSuccessResponse();
+}
+
+juce::var CommandProcessor::handleWriteTrace(const juce::var& params)
+{
+    if (!validateParameters(params, {"outputFile"})) {
+        return createErrorResponse("Missing required parameter: outputFile");
+    }
+    
+    const juce::String path = params.getProperty("outputFile", juce::var()).toString();
+    if (!juce::File::isAbsolutePath(path)) {
+        return createErrorResponse("outputFile must be an absolute path");
+    }
+    
+    // Works while recording too; the capture keeps going
+    const juce::File outputFile(path);
+    outputFile.deleteFile();
+    juce::FileOutputStream stream(outputFile);
+    if (!stream.openedOk()) {
+        return createErrorResponse("Cannot write " + outputFile.getFullPathName());
+    }
+    
+    const int numEvents = TraceRecorder::getInstance().writeChromeTrace(stream);
+    stream.flush();
+    if (stream.getStatus().failed()) {
+        return createErrorResponse("Cannot write " + outputFile.getFullPathName());
+    }
+    
+    juce::DynamicObject::Ptr result = new juce::DynamicObject();
+    result->setProperty("outputFile", outputFile.getFullPathName());
+    result->setProperty("numEvents", numEvents);
+    result->setProperty("droppedThreads", TraceRecorder::getInstance().getNumDroppedThreads());
+    return createSuccessResponse(juce::var(result.get()));
+}
+
 juce::var CommandProcessor::handleSetAudioDevice(const juce::var& params)
 {
     if (!audioEngine) {
@@ -167,6 +385,55 @@ juce::var CommandProcessor::handleGetDevices(const juce::var& params)
     return createSuccessResponse(juce::var(deviceArray));
 }
 
+juce::var CommandProcessor::handleBatch(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    const juce::var commands = params.getProperty("commands", juce::var());
+    if (!commands.isArray()) {
+        return createErrorResponse("Missing required parameter: commands (array)");
+    }
+    
+    // Nothing runs unless every command is well formed and would take effect
+    const auto status = audioEngine->getStatus();
+    const BatchLimits limits { status.numBuses, status.numMixerOutputs };
+    for (int index = 0; index < commands.size(); ++index) {
+        const juce::String problem = validateBatchCommand(commands[index], limits);
+        if (problem.isNotEmpty()) {
+            return createErrorResponse("Batch command " + juce::String(index) + ": " + problem);
+        }
+    }
+    
+    // Transport and matrix changes reach the audio thread together, so every
+    // cue the batch starts begins on the same sample. A command that still
+    // fails takes the whole batch back out; the rest are not run.
+    juce::Array<juce::var> results;
+    bool allSucceeded = true;
+    
+    audioEngine->beginTransaction();
+    for (int index = 0; index < commands.size() && allSucceeded; ++index) {
+        const juce::var result = processCommand(commands[index]);
+        const juce::var data = result.getProperty("data", juce::var());
+        allSucceeded = static_cast<bool>(result.getProperty("success", false))
+                       && !(data.isBool() && !static_cast<bool>(data));
+        results.add(result);
+    }
+    
+    if (allSucceeded) {
+        audioEngine->commitTransaction();
+    } else {
+        audioEngine->abortTransaction();
+    }
+    
+    juce::DynamicObject::Ptr response = new juce::DynamicObject();
+    response->setProperty("allSucceeded", allSucceeded);
+    response->setProperty("rolledBack", !allSucceeded);
+    response->setProperty("results", results);
+    return createSuccessResponse(juce::var(response.get()));
+}
+
 juce::var CommandProcessor::handleCreateCue(const juce::var& params)
 {
     if (!audioEngine) {
@@ -181,6 +448,12 @@ juce::var CommandProcessor::handleCreateCue(const juce::var& params)
     juce::String filePath = params.getProperty("filePath", juce::var()).toString();
     
     bool success = audioEngine->createAudioCue(cueId, filePath);
+    
+    // Optional: keep this cue resident in RAM
+    if (success && static_cast<bool>(params.getProperty("preload", false))) {
+        audioEngine->setCuePreload(cueId, true);
+    }
+    
     return createSuccessResponse(juce::var(success));
 }
 
@@ -214,8 +487,9 @@ juce::var CommandProcessor::handlePlayCue(const juce::var& params)
     juce::String cueId = params.getProperty("cueId", juce::var()).toString();
     double startTime = params.getProperty("startTime", 0.0);
     double fadeInTime = params.getProperty("fadeInTime", 0.0);
+    FadeCurve fadeCurve = FadeEngine::curveFromString(params.getProperty("fadeCurve", "linear").toString());
     
-    bool success = audioEngine->playCue(cueId, startTime, fadeInTime);
+    bool success = audioEngine->playCue(cueId, startTime, fadeInTime, fadeCurve);
     return createSuccessResponse(juce::var(success));
 }
 
@@ -231,8 +505,9 @@ juce::var CommandProcessor::handleStopCue(const juce::var& params)
     
     juce::String cueId = params.getProperty("cueId", juce::var()).toString();
     double fadeOutTime = params.getProperty("fadeOutTime", 0.0);
+    FadeCurve fadeCurve = FadeEngine::curveFromString(params.getProperty("fadeCurve", "linear").toString());
     
-    bool success = audioEngine->stopCue(cueId, fadeOutTime);
+    bool success = audioEngine->stopCue(cueId, fadeOutTime, fadeCurve);
     return createSuccessResponse(juce::var(success));
 }
 
@@ -276,6 +551,192 @@ juce::var CommandProcessor::handleStopAllCues(const juce::var& params)
     return createSuccessResponse();
 }
 
+juce::var CommandProcessor::handlePlayCueAt(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    if (!validateParameters(params, {"cueId"})) {
+        return createErrorResponse("Missing required parameter: cueId");
+    }
+    
+    juce::String cueId = params.getProperty("cueId", juce::var()).toString();
+    double startTime = params.getProperty("startTime", 0.0);
+    double fadeInTime = params.getProperty("fadeInTime", 0.0);
+    FadeCurve fadeCurve = FadeEngine::curveFromString(params.getProperty("fadeCurve", "linear").toString());
+    
+    // Either an engine sample position or a host time in milliseconds
+    bool success = false;
+    if (params.hasProperty("samplePosition")) {
+        juce::int64 samplePosition = params.getProperty("samplePosition", 0);
+        success = audioEngine->playCueAtSample(cueId, samplePosition, startTime, fadeInTime, fadeCurve);
+    }
+    else if (params.hasProperty("hostTime")) {
+        double hostTime = params.getProperty("hostTime", 0.0);
+        success = audioEngine->playCueAtHostTime(cueId, hostTime, startTime, fadeInTime, fadeCurve);
+    }
+    else {
+        return createErrorResponse("Missing required parameter: samplePosition or hostTime");
+    }
+    
+    return createSuccessResponse(juce::var(success));
+}
+
+juce::var CommandProcessor::handleGetClock(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    juce::DynamicObject::Ptr clockObj = new juce::DynamicObject();
+    clockObj->setProperty("samplePosition", audioEngine->getSamplePosition());
+    clockObj->setProperty("hostTime", juce::Time::getMillisecondCounterHiRes());
+    clockObj->setProperty("sampleRate", audioEngine->getStatus().sampleRate);
+    
+    return createSuccessResponse(juce::var(clockObj.get()));
+}
+
+juce::var CommandProcessor::handleSetCueTiming(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    if (!validateParameters(params, {"cueId"})) {
+        return createErrorResponse("Missing required parameter: cueId");
+    }
+    
+    juce::String cueId = params.getProperty("cueId", juce::var()).toString();
+    juce::String continueMode = params.getProperty("continueMode", "none").toString();
+    
+    CueSequencer::CueTiming timing;
+    timing.preWait = params.getProperty("preWait", 0.0);
+    timing.postWait = params.getProperty("postWait", 0.0);
+    timing.nextCueId = params.getProperty("nextCueId", juce::var()).toString();
+    
+    if (continueMode == "autoContinue") {
+        timing.continueMode = CueSequencer::ContinueMode::autoContinue;
+    }
+    else if (continueMode == "autoFollow") {
+        timing.continueMode = CueSequencer::ContinueMode::autoFollow;
+    }
+    else if (continueMode != "none") {
+        return createErrorResponse("continueMode must be none, autoContinue or autoFollow");
+    }
+    
+    bool success = audioEngine->setCueTiming(cueId, timing);
+    return createSuccessResponse(juce::var(success));
+}
+
+juce::var CommandProcessor::handleGoCue(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    if (!validateParameters(params, {"cueId"})) {
+        return createErrorResponse("Missing required parameter: cueId");
+    }
+    
+    juce::String cueId = params.getProperty("cueId", juce::var()).toString();
+    juce::int64 samplePosition = params.getProperty("samplePosition", -1);
+    
+    bool success = audioEngine->goCue(cueId, samplePosition);
+    return createSuccessResponse(juce::var(success));
+}
+
+juce::var CommandProcessor::handleSetCuePreload(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    if (!validateParameters(params, {"cueId", "preload"})) {
+        return createErrorResponse("Missing required parameters: cueId, preload");
+    }
+    
+    juce::String cueId = params.getProperty("cueId", juce::var()).toString();
+    bool preload = params.getProperty("preload", false);
+    
+    bool success = audioEngine->setCuePreload(cueId, preload);
+    return createSuccessResponse(juce::var(success));
+}
+
+juce::var CommandProcessor::handleSetPreloadBudget(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    if (!validateParameters(params, {"budgetBytes"})) {
+        return createErrorResponse("Missing required parameter: budgetBytes");
+    }
+    
+    juce::int64 budgetBytes = params.getProperty("budgetBytes", 0);
+    if (budgetBytes < 0) {
+        return createErrorResponse("budgetBytes must not be negative");
+    }
+    
+    audioEngine->setPreloadBudget(static_cast<size_t>(budgetBytes));
+    return createSuccessResponse();
+}
+
+juce::var CommandProcessor::handleSetRenderThreads(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    if (!validateParameters(params, {"numThreads"})) {
+        return createErrorResponse("Missing required parameter: numThreads");
+    }
+    
+    int numThreads = params.getProperty("numThreads", 0);
+    if (!audioEngine->setRenderThreads(numThreads)) {
+        return createErrorResponse("numThreads must be between 0 and " + juce::String(RenderPool::MAX_WORKERS - 1));
+    }
+    
+    return createSuccessResponse();
+}
+
+juce::var CommandProcessor::handleRenderOffline(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    if (!validateParameters(params, {"outputFile"})) {
+        return createErrorResponse("Missing required parameter: outputFile");
+    }
+    
+    AudioEngine::OfflineRenderSettings settings;
+    settings.outputFile = juce::File(params.getProperty("outputFile", juce::var()).toString());
+    settings.sampleRate = params.getProperty("sampleRate", settings.sampleRate);
+    settings.blockSize = params.getProperty("blockSize", settings.blockSize);
+    settings.bitDepth = params.getProperty("bitDepth", settings.bitDepth);
+    settings.durationSeconds = params.getProperty("durationSeconds", settings.durationSeconds);
+    settings.tailSeconds = params.getProperty("tailSeconds", settings.tailSeconds);
+    settings.renderThreads = params.getProperty("renderThreads", settings.renderThreads);
+    settings.goCueId = params.getProperty("goCueId", juce::var()).toString();
+    
+    if (!audioEngine->startOfflineRender(settings)) {
+        return createErrorResponse("Cannot render offline (engine running, render in progress or unsupported file type)");
+    }
+    
+    return createSuccessResponse();
+}
+
+juce::var CommandProcessor::handleCancelOfflineRender(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    audioEngine->cancelOfflineRender();
+    return createSuccessResponse();
+}
+
 juce::var CommandProcessor::handleSetCrosspoint(const juce::var& params)
 {
     if (!audioEngine) {
@@ -290,8 +751,9 @@ juce::var CommandProcessor::handleSetCrosspoint(const juce::var& params)
     int input = params.getProperty("input", 0);
     int output = params.getProperty("output", 0);
     float level = params.getProperty("level", 0.0f);
+    bool muted = params.getProperty("muted", false);
     
-    bool success = audioEngine->setCrosspoint(cueId, input, output, level);
+    bool success = audioEngine->setCrosspoint(cueId, input, output, level, muted);
     return createSuccessResponse(juce::var(success));
 }
 
@@ -326,8 +788,59 @@ juce::var CommandProcessor::handleSetInputLevel(const juce::var& params)
     juce::String cueId = params.getProperty("cueId", juce::var()).toString();
     int input = params.getProperty("input", 0);
     float level = params.getProperty("level", 1.0f);
+    bool muted = params.getProperty("muted", false);
+    
+    bool success = audioEngine->setInputLevel(cueId, input, level, muted);
+    return createSuccessResponse(juce::var(success));
+}
+
+juce::var CommandProcessor::handleSetCueOutputLevel(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    if (!validateParameters(params, {"cueId", "output", "level"})) {
+        return createErrorResponse("Missing required parameters: cueId, output, level");
+    }
+    
+    juce::String cueId = params.getProperty("cueId", juce::var()).toString();
+    int output = params.getProperty("output", 0);
+    float level = params.getProperty("level", 1.0f);
+    bool muted = params.getProperty("muted", false);
+    
+    bool success = audioEngine->setCueOutputLevel(cueId, output, level, muted);
+    return createSuccessResponse(juce::var(success));
+}
+
+juce::var CommandProcessor::handleSetCueMatrixRouting(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    if (!validateParameters(params, {"cueId", "matrix"})) {
+        return createErrorResponse("Missing required parameters: cueId, matrix");
+    }
+    
+    juce::String cueId = params.getProperty("cueId", juce::var()).toString();
+    const juce::var matrix = params.getProperty("matrix", juce::var());
+    if (!matrix.isArray()) {
+        return createErrorResponse("matrix must be an array of per-channel level arrays");
+    }
     
-    bool success = audioEngine->setInputLevel(cueId, input, level);
+    std::vector<std::vector<float>> levels;
+    for (const auto& row : *matrix.getArray()) {
+        std::vector<float> rowLevels;
+        if (row.isArray()) {
+            for (const auto& level : *row.getArray()) {
+                rowLevels.push_back(static_cast<float>(level));
+            }
+        }
+        levels.push_back(std::move(rowLevels));
+    }
+    
+    bool success = audioEngine->setCueMatrix(cueId, levels);
     return createSuccessResponse(juce::var(success));
 }
 
@@ -382,6 +895,24 @@ juce::var CommandProcessor::handleSoloOutput(const juce::var& params)
     return createSuccessResponse(juce::var(success));
 }
 
+juce::var CommandProcessor::handleSetGainRampTime(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    if (!validateParameters(params, {"seconds"})) {
+        return createErrorResponse("Missing required parameter: seconds");
+    }
+    
+    float seconds = params.getProperty("seconds", 0.0f);
+    if (!audioEngine->setGainRampTime(seconds)) {
+        return createErrorResponse("seconds must not be negative");
+    }
+    
+    return createSuccessResponse();
+}
+
 juce::var CommandProcessor::handleSetPatchRouting(const juce::var& params)
 {
     if (!audioEngine) {
@@ -417,6 +948,43 @@ juce::var CommandProcessor::handleGetPatchRouting(const juce::var& params)
     return createSuccessResponse(juce::var(level));
 }
 
+juce::var CommandProcessor::handleSetPatchFusion(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    if (!validateParameters(params, {"enabled"})) {
+        return createErrorResponse("Missing required parameter: enabled");
+    }
+    
+    audioEngine->setPatchFusion(params.getProperty("enabled", true));
+    
+    // Whether it actually fused also depends on bus metering
+    juce::DynamicObject::Ptr result = new juce::DynamicObject();
+    result->setProperty("enabled", audioEngine->isPatchFusionEnabled());
+    result->setProperty("fused", audioEngine->isPatchFused());
+    return createSuccessResponse(juce::var(result.get()));
+}
+
+juce::var CommandProcessor::handleSetBusMetering(const juce::var& params)
+{
+    if (!audioEngine) {
+        return createErrorResponse("AudioEngine not available");
+    }
+    
+    if (!validateParameters(params, {"enabled"})) {
+        return createErrorResponse("Missing required parameter: enabled");
+    }
+    
+    audioEngine->setBusMetering(params.getProperty("enabled", false));
+    
+    juce::DynamicObject::Ptr result = new juce::DynamicObject();
+    result->setProperty("enabled", audioEngine->isBusMeteringEnabled());
+    result->setProperty("fused", audioEngine->isPatchFused());
+    return createSuccessResponse(juce::var(result.get()));
+}
+
 juce::var CommandProcessor::createErrorResponse(const juce::String& message, int code)
 {
     juce::DynamicObject::Ptr response = new juce::DynamicObject();
@@ -436,6 +1004,128 @@ juce::var CommandProcessor::createSuccessResponse(const juce::var& data)
     return juce::var(response.get());
 }
 
+juce::String CommandProcessor::validateBatchCommand(const juce::var& command, const BatchLimits& limits) const
+{
+    if (!command.isObject()) {
+        return "Command must be an object";
+    }
+    
+    const juce::String commandName = command.getProperty("command", juce::var()).toString();
+    auto it = commandParameters.find(commandName);
+    if (it == commandParameters.end()) {
+        return commandName.isEmpty() ? juce::String("Missing command name") : "Unknown command: " + commandName;
+    }
+    
+    // Only commands whose effect the transaction can hold back until commit
+    // (transport, matrices) or that change nothing. Lifecycle, cue loading,
+    // preload and render-thread changes republish the cue list or reopen the
+    // device straight away, so they are refused rather than half-applied
+    static const juce::StringArray batchable {
+        "playCue", "stopCue", "pauseCue", "resumeCue", "stopAllCues", "playCueAt", "goCue",
+        "setCrosspoint", "setInputLevel", "setCueInputLevel", "setCueOutputLevel", "setCueMatrixRouting",
+        "setOutputLevel", "muteOutput", "soloOutput",
+        "getStatus", "getClock", "getCrosspoint", "getMeters"
+    };
+    if (!batchable.contains(commandName)) {
+        return commandName + " cannot be batched";
+    }
+    
+    const juce::var params = command.getProperty("params", juce::var());
+    for (const auto& param : it->second) {
+        if (!params.isObject() || !params.hasProperty(param)) {
+            return "Missing required parameter: " + param;
+        }
+    }
+    
+    return validateBatchEffect(commandName, params, limits);
+}
+
+juce::String CommandProcessor::validateBatchEffect(const juce::String& commandName, const juce::var& params,
+                                                   const BatchLimits& limits) const
+{
+    // What the command would do, checked against the engine as it is now;
+    // batches can't create or load cues, so this still holds at commit
+    auto checkIndex = [&params](const char* name, int limit) -> juce::String {
+        const juce::var value = params.getProperty(name, juce::var());
+        if (!value.isInt() && !value.isInt64() && !value.isDouble()) {
+            return juce::String(name) + " must be a number";
+        }
+        const double index = value;
+        if (index != std::floor(index) || index < 0.0 || index >= limit) {
+            return juce::String(name) + " out of range (0-" + juce::String(limit - 1) + ")";
+        }
+        return {};
+    };
+    
+    auto checkNonNegative = [&params](const char* name) -> juce::String {
+        if (!params.hasProperty(name)) {
+            return {};
+        }
+        const juce::var value = params.getProperty(name, juce::var());
+        const double number = value;
+        if ((!value.isInt() && !value.isInt64() && !value.isDouble()) || !std::isfinite(number) || number < 0.0) {
+            return juce::String(name) + " must be a non-negative number";
+        }
+        return {};
+    };
+    
+    const juce::String cueId = params.getProperty("cueId", juce::var()).toString();
+    const bool cueAddressed = params.hasProperty("cueId");
+    const bool masterMatrix = cueId.isEmpty();
+    static const juce::StringArray cueMatrixCommands { "setCrosspoint", "getCrosspoint", "setInputLevel", "setCueInputLevel" };
+    
+    // Cue commands need a loaded cue; matrix commands only when they name one
+    if (cueAddressed && !(masterMatrix && cueMatrixCommands.contains(commandName))
+        && !audioEngine->isCueLoaded(cueId)) {
+        return "Cue not found or not loaded: " + cueId;
+    }
+    
+    juce::String problem;
+    if (commandName == "setCrosspoint" || commandName == "getCrosspoint") {
+        problem = masterMatrix ? checkIndex("input", limits.numBuses) : checkIndex("input", CueMatrix::MAX_CHANNELS);
+        if (problem.isEmpty()) {
+            problem = checkIndex("output", masterMatrix ? limits.numMixerOutputs : limits.numBuses);
+        }
+    }
+    else if (commandName == "setInputLevel" || commandName == "setCueInputLevel") {
+        problem = checkIndex("input", masterMatrix ? limits.numBuses : CueMatrix::MAX_CHANNELS);
+    }
+    else if (commandName == "setCueOutputLevel") {
+        problem = checkIndex("output", limits.numBuses);
+    }
+    else if (commandName == "setOutputLevel" || commandName == "muteOutput" || commandName == "soloOutput") {
+        problem = checkIndex("output", limits.numMixerOutputs);
+    }
+    else if (commandName == "setCueMatrixRouting") {
+        const juce::var matrix = params.getProperty("matrix", juce::var());
+        if (!matrix.isArray() || matrix.size() > CueMatrix::MAX_CHANNELS) {
+            return "matrix must be an array of at most " + juce::String(CueMatrix::MAX_CHANNELS) + " rows";
+        }
+        for (const auto& row : *matrix.getArray()) {
+            if (!row.isArray() || row.size() > limits.numBuses) {
+                return "matrix rows must be arrays of at most " + juce::String(limits.numBuses) + " levels";
+            }
+            for (const auto& level : *row.getArray()) {
+                const double number = level;
+                if (!std::isfinite(number) || number < 0.0) {
+                    return "matrix levels must be non-negative numbers";
+                }
+            }
+        }
+    }
+    else if (commandName == "playCueAt" && !params.hasProperty("samplePosition") && !params.hasProperty("hostTime")) {
+        problem = "Missing required parameter: samplePosition or hostTime";
+    }
+    
+    for (const char* name : { "level", "startTime", "fadeInTime", "fadeOutTime" }) {
+        if (problem.isEmpty()) {
+            problem = checkNonNegative(name);
+        }
+    }
+    
+    return problem;
+}
+
 bool CommandProcessor::validateParameters(const juce::var& params, const juce::StringArray& required)
 {
     if (!params.isObject()) {
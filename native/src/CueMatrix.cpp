@@ -0,0 +1,234 @@
+#include "../include/CueMatrix.h"
+
+CueMatrix::CueMatrix(int numOutputs)
+{
+    for (int channel = 0; channel < MAX_CHANNELS; ++channel) {
+        inputLevels[channel].store(1.0f);
+    }
+
+    configure(numOutputs);
+    setDefaultRouting();
+}
+
+void CueMatrix::configure(int numOutputs)
+{
+    numOutputs = juce::jmax(1, numOutputs);
+    const int words = (numOutputs + MASK_BITS - 1) / MASK_BITS;
+
+    std::vector<std::atomic<float>> newLevels(static_cast<size_t>(MAX_CHANNELS * numOutputs));
+    std::vector<std::atomic<juce::uint64>> newRouteMasks(static_cast<size_t>(MAX_CHANNELS * words));
+    std::vector<std::atomic<juce::uint64>> newMutedMasks(static_cast<size_t>(MAX_CHANNELS * words));
+    std::vector<std::atomic<float>> newOutputLevels(static_cast<size_t>(numOutputs));
+    std::vector<std::atomic<juce::uint64>> newOutputMutes(static_cast<size_t>(words));
+
+    for (auto& mask : newRouteMasks) {
+        mask.store(0);
+    }
+    for (auto& mask : newMutedMasks) {
+        mask.store(0);
+    }
+    for (auto& mask : newOutputMutes) {
+        mask.store(0);
+    }
+
+    // Carry over every crosspoint and output that still exists
+    for (int channel = 0; channel < MAX_CHANNELS; ++channel) {
+        for (int output = 0; output < numOutputs; ++output) {
+            const bool kept = output < numOutputChannels;
+            const float level = kept ? levels[levelIndex(channel, output)].load() : 0.0f;
+            const bool muted = kept && (mutedMasks[maskIndex(channel, output)].load() & maskBit(output)) != 0;
+            const auto word = static_cast<size_t>(channel * words + output / MASK_BITS);
+
+            newLevels[static_cast<size_t>(channel * numOutputs + output)].store(level);
+            if (level > 0.0f) {
+                newRouteMasks[word].fetch_or(maskBit(output));
+            }
+            if (muted) {
+                newMutedMasks[word].fetch_or(maskBit(output));
+            }
+        }
+    }
+
+    for (int output = 0; output < numOutputs; ++output) {
+        const bool kept = output < numOutputChannels;
+        newOutputLevels[static_cast<size_t>(output)].store(kept ? outputLevels[output].load() : 1.0f);
+        if (kept && (outputMutes[output / MASK_BITS].load() & maskBit(output)) != 0) {
+            newOutputMutes[static_cast<size_t>(output / MASK_BITS)].fetch_or(maskBit(output));
+        }
+    }
+
+    levels = std::move(newLevels);
+    routeMasks = std::move(newRouteMasks);
+    mutedMasks = std::move(newMutedMasks);
+    outputLevels = std::move(newOutputLevels);
+    outputMutes = std::move(newOutputMutes);
+    numOutputChannels = numOutputs;
+    numMaskWords = words;
+
+    // Nothing is sounding while reconfiguring, so ramps start from silence
+    appliedGains.assign(static_cast<size_t>(MAX_CHANNELS * numOutputs), 0.0f);
+    appliedMasks.assign(static_cast<size_t>(MAX_CHANNELS * words), 0);
+}
+
+void CueMatrix::setCrosspoint(int channel, int output, float level, bool muted)
+{
+    if (channel < 0 || channel >= MAX_CHANNELS || output < 0 || output >= numOutputChannels) {
+        return;
+    }
+
+    const float clamped = clampLevel(level);
+    const juce::uint64 bit = maskBit(output);
+    const int word = maskIndex(channel, output);
+
+    levels[levelIndex(channel, output)].store(clamped);
+
+    if (muted) {
+        mutedMasks[word].fetch_or(bit);
+    } else {
+        mutedMasks[word].fetch_and(~bit);
+    }
+
+    if (clamped > 0.0f) {
+        routeMasks[word].fetch_or(bit);
+    } else {
+        routeMasks[word].fetch_and(~bit);
+    }
+}
+
+float CueMatrix::getCrosspoint(int channel, int output) const
+{
+    if (channel >= 0 && channel < MAX_CHANNELS && output >= 0 && output < numOutputChannels) {
+        return levels[levelIndex(channel, output)].load();
+    }
+    return 0.0f;
+}
+
+bool CueMatrix::isCrosspointMuted(int channel, int output) const
+{
+    if (channel >= 0 && channel < MAX_CHANNELS && output >= 0 && output < numOutputChannels) {
+        return (mutedMasks[maskIndex(channel, output)].load() & maskBit(output)) != 0;
+    }
+    return false;
+}
+
+void CueMatrix::setInputLevel(int channel, float level, bool muted)
+{
+    if (channel < 0 || channel >= MAX_CHANNELS) {
+        return;
+    }
+
+    const juce::uint64 bit = juce::uint64(1) << channel;
+    inputLevels[channel].store(clampLevel(level));
+
+    if (muted) {
+        inputMutes.fetch_or(bit);
+    } else {
+        inputMutes.fetch_and(~bit);
+    }
+}
+
+float CueMatrix::getInputLevel(int channel) const
+{
+    if (channel >= 0 && channel < MAX_CHANNELS) {
+        return inputLevels[channel].load();
+    }
+    return 0.0f;
+}
+
+void CueMatrix::setOutputLevel(int output, float level, bool muted)
+{
+    if (output < 0 || output >= numOutputChannels) {
+        return;
+    }
+
+    outputLevels[output].store(clampLevel(level));
+
+    if (muted) {
+        outputMutes[output / MASK_BITS].fetch_or(maskBit(output));
+    } else {
+        outputMutes[output / MASK_BITS].fetch_and(~maskBit(output));
+    }
+}
+
+float CueMatrix::getOutputLevel(int output) const
+{
+    if (output >= 0 && output < numOutputChannels) {
+        return outputLevels[output].load();
+    }
+    return 0.0f;
+}
+
+void CueMatrix::setDefaultRouting()
+{
+    clearAllCrosspoints();
+
+    for (int channel = 0; channel < juce::jmin(MAX_CHANNELS, numOutputChannels); ++channel) {
+        setCrosspoint(channel, channel, 1.0f);
+    }
+}
+
+void CueMatrix::clearAllCrosspoints()
+{
+    for (auto& mask : routeMasks) {
+        mask.store(0);
+    }
+    for (auto& mask : mutedMasks) {
+        mask.store(0);
+    }
+    for (auto& level : levels) {
+        level.store(0.0f);
+    }
+}
+
+void CueMatrix::process(const juce::AudioBuffer<float>& source, int numChannels,
+                        juce::AudioBuffer<float>& destination, int destinationStart, int numSamples)
+{
+    const int channelsToMix = juce::jmin(numChannels, source.getNumChannels(), MAX_CHANNELS);
+    const int numOutputs = juce::jmin(destination.getNumChannels(), numOutputChannels);
+    const juce::uint64 mutedInputs = inputMutes.load();
+
+    for (int channel = 0; channel < channelsToMix; ++channel) {
+        const bool inputMuted = (mutedInputs >> channel) & 1;
+        const float inputLevel = inputMuted ? 0.0f : inputLevels[channel].load();
+
+        for (int word = 0; word < numMaskWords; ++word) {
+            const auto maskSlot = static_cast<size_t>(channel * numMaskWords + word);
+            const juce::uint64 routes = routeMasks[maskSlot].load() & ~mutedMasks[maskSlot].load()
+                                      & ~outputMutes[static_cast<size_t>(word)].load();
+
+            // Live routes plus any still sounding from last block, which ramp out
+            juce::uint64 pending = routes | appliedMasks[maskSlot];
+            juce::uint64 stillApplied = 0;
+
+            for (int bitIndex = 0; pending != 0; ++bitIndex, pending >>= 1) {
+                if ((pending & 1) == 0) {
+                    continue;
+                }
+
+                const int output = word * MASK_BITS + bitIndex;
+                const juce::uint64 bit = juce::uint64(1) << bitIndex;
+                const float target = (routes & bit) != 0 ? levels[levelIndex(channel, output)].load()
+                                                           * inputLevel * outputLevels[output].load()
+                                                         : 0.0f;
+
+                float& applied = appliedGains[static_cast<size_t>(levelIndex(channel, output))];
+                if (output < numOutputs && (applied != 0.0f || target != 0.0f)) {
+                    destination.addFromWithRamp(output, destinationStart, source.getReadPointer(channel),
+                                                numSamples, applied, target);
+                }
+
+                applied = target;
+                if (target != 0.0f) {
+                    stillApplied |= bit;
+                }
+            }
+
+            appliedMasks[maskSlot] = stillApplied;
+        }
+    }
+}
+
+float CueMatrix::clampLevel(float level)
+{
+    return juce::jlimit(0.0f, juce::Decibels::decibelsToGain(MAX_GAIN_DB), level);
+}
@@ -0,0 +1,226 @@
+#include "../include/CueSequencer.h"
+#include "../include/AudioCue.h"
+
+#include <algorithm>
+#include <cmath>
+
+//==============================================================================
+// Graph
+//==============================================================================
+
+const CueSequencer::Graph::Node* CueSequencer::Graph::find(const AudioCue* cue) const
+{
+    auto it = nodes.find(cue);
+    return it != nodes.end() ? &it->second : nullptr;
+}
+
+//==============================================================================
+// CueSequencer
+//==============================================================================
+
+CueSequencer::CueSequencer()
+    : events(static_cast<size_t>(EVENT_QUEUE_SIZE))
+{
+    pendingTriggers.reserve(MAX_PENDING_TRIGGERS);
+    runningCues.reserve(MAX_RUNNING_CUES);
+}
+
+CueSequencer::~CueSequencer()
+{
+}
+
+void CueSequencer::setCueTiming(const juce::String& cueId, const CueTiming& timing)
+{
+    CueTiming clamped = timing;
+    clamped.preWait = juce::jmax(0.0, timing.preWait);
+    clamped.postWait = juce::jmax(0.0, timing.postWait);
+    timings[cueId] = clamped;
+}
+
+bool CueSequencer::getCueTiming(const juce::String& cueId, CueTiming& timing) const
+{
+    auto it = timings.find(cueId);
+    if (it == timings.end()) {
+        return false;
+    }
+
+    timing = it->second;
+    return true;
+}
+
+std::unique_ptr<CueSequencer::Graph> CueSequencer::buildGraph(
+    const std::map<juce::String, std::unique_ptr<AudioCue>>& cues, const AudioCue* excludedCue) const
+{
+    auto graph = std::make_unique<Graph>();
+    graph->nodes.reserve(cues.size());
+
+    for (const auto& pair : cues) {
+        if (pair.second.get() == excludedCue) {
+            continue;
+        }
+
+        Graph::Node node;
+        node.cue = pair.second.get();
+
+        auto timing = timings.find(pair.first);
+        if (timing != timings.end()) {
+            node.preWait = timing->second.preWait;
+            node.postWait = timing->second.postWait;
+            node.continueMode = timing->second.continueMode;
+
+            // Links to cues that do not exist (yet) simply end the chain
+            auto next = cues.find(timing->second.nextCueId);
+            if (next != cues.end() && next->second.get() != excludedCue) {
+                node.next = next->second.get();
+            }
+        }
+
+        graph->nodes[node.cue] = node;
+    }
+
+    return graph;
+}
+
+bool CueSequencer::go(AudioCue* cue, juce::int64 goSample)
+{
+    return addTrigger(TriggerType::go, cue, goSample);
+}
+
+void CueSequencer::clear()
+{
+    pendingTriggers.clear();
+    runningCues.clear();
+}
+
+void CueSequencer::process(const Graph* graph, juce::int64 blockStartSample, int numSamples, double sampleRate)
+{
+    if (graph == nullptr || pendingTriggers.empty()) {
+        return;
+    }
+
+    const juce::int64 blockEndSample = blockStartSample + numSamples;
+
+    // Fire in time order; triggers added while firing (zero waits) are picked
+    // up in the same block. The bound stops a zero-wait loop in the cue list
+    // from spinning forever - the rest carries over to the next block.
+    for (int fired = 0; fired < MAX_PENDING_TRIGGERS; ++fired) {
+        auto earliest = pendingTriggers.end();
+        for (auto it = pendingTriggers.begin(); it != pendingTriggers.end(); ++it) {
+            if (it->fireSample < blockEndSample
+                && (earliest == pendingTriggers.end() || it->fireSample < earliest->fireSample)) {
+                earliest = it;
+            }
+        }
+
+        if (earliest == pendingTriggers.end()) {
+            break;
+        }
+
+        // Late triggers fire at the top of the block
+        Trigger trigger = *earliest;
+        trigger.fireSample = juce::jmax(trigger.fireSample, blockStartSample);
+        pendingTriggers.erase(earliest);
+
+        fireTrigger(*graph, trigger, sampleRate);
+    }
+}
+
+void CueSequencer::checkCompletions(const Graph* graph, juce::int64 blockEndSample)
+{
+    for (auto it = runningCues.begin(); it != runningCues.end();) {
+        AudioCue* cue = *it;
+        if (cue->isPlaying()) {
+            ++it;
+            continue;
+        }
+
+        // The engine reports the completion itself, as it does for every voice
+
+        // Auto-follow only when the cue played out, not when it was stopped
+        const auto* node = graph != nullptr ? graph->find(cue) : nullptr;
+        if (node != nullptr && node->continueMode == ContinueMode::autoFollow
+            && node->next != nullptr && cue->hasReachedEnd()) {
+            addTrigger(TriggerType::go, node->next, blockEndSample);
+        }
+
+        it = runningCues.erase(it);
+    }
+}
+
+bool CueSequencer::popEvent(SequencerEvent& event)
+{
+    const auto scope = eventFifo.read(1);
+    if (scope.blockSize1 > 0) {
+        event = events[static_cast<size_t>(scope.startIndex1)];
+        return true;
+    }
+    if (scope.blockSize2 > 0) {
+        event = events[static_cast<size_t>(scope.startIndex2)];
+        return true;
+    }
+    return false;
+}
+
+bool CueSequencer::addTrigger(TriggerType type, AudioCue* cue, juce::int64 fireSample)
+{
+    if (cue == nullptr || static_cast<int>(pendingTriggers.size()) >= MAX_PENDING_TRIGGERS) {
+        return false;
+    }
+
+    Trigger trigger;
+    trigger.type = type;
+    trigger.cue = cue;
+    trigger.fireSample = fireSample;
+    pendingTriggers.push_back(trigger);
+    return true;
+}
+
+void CueSequencer::fireTrigger(const Graph& graph, const Trigger& trigger, double sampleRate)
+{
+    // Cues that are being edited are missing from the graph; drop their triggers
+    const auto* node = graph.find(trigger.cue);
+    if (node == nullptr) {
+        return;
+    }
+
+    if (trigger.type == TriggerType::go) {
+        const auto preWait = static_cast<juce::int64>(std::llround(node->preWait * sampleRate));
+        addTrigger(TriggerType::start, trigger.cue, trigger.fireSample + preWait);
+        return;
+    }
+
+    // The cue renders after the sequencer, so it starts inside this block.
+    // One that can't play (no file loaded) didn't start and doesn't chain on
+    if (!trigger.cue->play(0.0, 0.0, trigger.fireSample)) {
+        return;
+    }
+    pushEvent(SequencerEvent::Type::cueStarted, trigger.cue, trigger.fireSample);
+
+    if (std::find(runningCues.begin(), runningCues.end(), trigger.cue) == runningCues.end()
+        && static_cast<int>(runningCues.size()) < MAX_RUNNING_CUES) {
+        runningCues.push_back(trigger.cue);
+    }
+
+    if (node->continueMode == ContinueMode::autoContinue && node->next != nullptr) {
+        const auto postWait = static_cast<juce::int64>(std::llround(node->postWait * sampleRate));
+        addTrigger(TriggerType::go, node->next, trigger.fireSample + postWait);
+    }
+}
+
+void CueSequencer::pushEvent(SequencerEvent::Type type, AudioCue* cue, juce::int64 samplePosition)
+{
+    // Events are dropped rather than blocking the audio thread if the UI falls behind
+    const auto scope = eventFifo.write(1);
+    SequencerEvent* slot = nullptr;
+    if (scope.blockSize1 > 0) {
+        slot = &events[static_cast<size_t>(scope.startIndex1)];
+    } else if (scope.blockSize2 > 0) {
+        slot = &events[static_cast<size_t>(scope.startIndex2)];
+    }
+
+    if (slot != nullptr) {
+        slot->type = type;
+        slot->cue = cue;
+        slot->samplePosition = samplePosition;
+    }
+}
@@ -0,0 +1,336 @@
+#include "../include/DiskStreamer.h"
+#include "../include/TraceRecorder.h"
+
+//==============================================================================
+// DiskStream
+//==============================================================================
+
+DiskStream::DiskStream(std::unique_ptr<juce::AudioFormatReader> sourceReader, double readAhead)
+    : reader(std::move(sourceReader))
+    , numChannels(reader ? static_cast<int>(reader->numChannels) : 0)
+    , sourceSampleRate(reader ? reader->sampleRate : 0.0)
+    , sourceLength(reader ? reader->lengthInSamples : 0)
+    , readAheadSeconds(readAhead)
+{
+    prepare(sourceSampleRate > 0.0 ? sourceSampleRate : 44100.0);
+}
+
+DiskStream::~DiskStream()
+{
+}
+
+void DiskStream::prepare(double outputSampleRate)
+{
+    // Must only be called while no DiskStreamer worker owns this stream
+    const double ratio = (sourceSampleRate > 0.0 && outputSampleRate > 0.0)
+                       ? sourceSampleRate / outputSampleRate
+                       : 1.0;
+
+    resampleRatio.store(ratio);
+    outputLength.store(static_cast<juce::int64>(static_cast<double>(sourceLength) / ratio));
+
+    capacity = juce::jmax(READ_CHUNK_SAMPLES * 2,
+                          static_cast<int>(std::ceil(readAheadSeconds * outputSampleRate)));
+
+    const int channels = juce::jmax(1, numChannels);
+    ring.setSize(channels, capacity);
+    ring.clear();
+    chunkBuffer.setSize(channels, READ_CHUNK_SAMPLES);
+    sourceBuffer.setSize(channels, static_cast<int>(std::ceil(READ_CHUNK_SAMPLES * ratio)) + 8);
+    interpolators.resize(static_cast<size_t>(channels));
+
+    // Restart from the top of the file
+    readPosition.store(0, std::memory_order_release);
+    seekGeneration.store(seekGeneration.load() + 1, std::memory_order_release);
+}
+
+int DiskStream::read(juce::AudioBuffer<float>& destination, int numSamples)
+{
+    const auto position = readPosition.load(std::memory_order_relaxed);
+    const auto remaining = juce::jmax<juce::int64>(0, outputLength.load() - position);
+    const int wanted = static_cast<int>(juce::jmin<juce::int64>(numSamples, remaining));
+
+    if (wanted <= 0) {
+        return 0;
+    }
+
+    // Data in the ring belongs to an older seek until the producer catches up
+    if (filledGeneration.load(std::memory_order_acquire) != seekGeneration.load(std::memory_order_relaxed)) {
+        underrunCount.fetch_add(1);
+        return 0;
+    }
+
+    const auto available = writePosition.load(std::memory_order_acquire) - position;
+    const int numToCopy = static_cast<int>(juce::jlimit<juce::int64>(0, wanted, available));
+
+    if (numToCopy < wanted) {
+        underrunCount.fetch_add(1);
+    }
+
+    if (numToCopy > 0) {
+        const int ringStart = static_cast<int>(position % capacity);
+        const int firstPart = juce::jmin(numToCopy, capacity - ringStart);
+        const int secondPart = numToCopy - firstPart;
+
+        for (int ch = 0; ch < juce::jmin(destination.getNumChannels(), numChannels); ++ch) {
+            destination.copyFrom(ch, 0, ring, ch, ringStart, firstPart);
+            if (secondPart > 0) {
+                destination.copyFrom(ch, firstPart, ring, ch, 0, secondPart);
+            }
+        }
+
+        readPosition.store(position + numToCopy, std::memory_order_release);
+    }
+
+    return numToCopy;
+}
+
+void DiskStream::seek(juce::int64 outputPosition)
+{
+    outputPosition = juce::jlimit<juce::int64>(0, outputLength.load(), outputPosition);
+    const juce::SpinLock::ScopedLockType lock(seekLock);
+    
+    // Already there (cued from the control thread, say): whatever fill is in
+    // flight is for this position, so don't restart it
+    if (outputPosition == readPosition.load(std::memory_order_relaxed)) {
+        return;
+    }
+    
+    const auto generation = seekGeneration.load(std::memory_order_relaxed);
+
+    // Forward seeks inside the data already buffered need no refill
+    if (filledGeneration.load(std::memory_order_acquire) == generation) {
+        const auto current = readPosition.load(std::memory_order_relaxed);
+        if (outputPosition >= current && outputPosition <= writePosition.load(std::memory_order_acquire)) {
+            readPosition.store(outputPosition, std::memory_order_release);
+            return;
+        }
+    }
+
+    readPosition.store(outputPosition, std::memory_order_release);
+    seekGeneration.store(generation + 1, std::memory_order_release);
+}
+
+bool DiskStream::isFinished() const
+{
+    return readPosition.load(std::memory_order_acquire) >= outputLength.load();
+}
+
+bool DiskStream::isReadyFor(int numSamples) const
+{
+    // True when read() could deliver numSamples (or the rest of the file)
+    // without an underrun
+    const auto position = readPosition.load(std::memory_order_acquire);
+    const auto wanted = juce::jmin<juce::int64>(numSamples, outputLength.load() - position);
+    if (wanted <= 0) {
+        return true;
+    }
+
+    if (filledGeneration.load(std::memory_order_acquire) != seekGeneration.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    return writePosition.load(std::memory_order_acquire) - position >= wanted;
+}
+
+bool DiskStream::service()
+{
+    if (reader == nullptr) {
+        return false;
+    }
+
+    const auto generation = seekGeneration.load(std::memory_order_acquire);
+    const auto consumerPosition = readPosition.load(std::memory_order_acquire);
+
+    // The consumer repositioned: restart decoding from its new read position
+    if (generation != filledGeneration.load(std::memory_order_relaxed)) {
+        producerRatio = resampleRatio.load();
+        sourcePosition = static_cast<juce::int64>(static_cast<double>(consumerPosition) * producerRatio);
+        for (auto& interpolator : interpolators) {
+            interpolator.reset();
+        }
+
+        writePosition.store(consumerPosition, std::memory_order_release);
+        filledGeneration.store(generation, std::memory_order_release);
+    }
+
+    const auto writePos = writePosition.load(std::memory_order_relaxed);
+    const auto totalLength = outputLength.load();
+    if (writePos >= totalLength) {
+        return false;
+    }
+
+    const auto freeSpace = static_cast<juce::int64>(capacity) - (writePos - consumerPosition);
+    const int numToRead = static_cast<int>(juce::jmin<juce::int64>(freeSpace,
+                                                                   READ_CHUNK_SAMPLES,
+                                                                   totalLength - writePos));
+
+    // Wait for a worthwhile amount of space unless this is the tail of the file
+    if (numToRead <= 0 || (numToRead < READ_CHUNK_SAMPLES / 4 && writePos + numToRead < totalLength)) {
+        return false;
+    }
+
+    const int numRead = readChunk(numToRead);
+    if (numRead <= 0) {
+        return false;
+    }
+
+    // Discard the chunk if the consumer moved while we were reading
+    if (seekGeneration.load(std::memory_order_acquire) != generation) {
+        return true;
+    }
+
+    writeToRing(writePos, chunkBuffer, numRead);
+    writePosition.store(writePos + numRead, std::memory_order_release);
+    return true;
+}
+
+int DiskStream::readChunk(int numSamples)
+{
+    const TraceRecorder::Scope trace("disk", "read", numSamples);
+
+    if (std::abs(producerRatio - 1.0) < 1.0e-9) {
+        if (!reader->read(chunkBuffer.getArrayOfWritePointers(), numChannels, sourcePosition, numSamples)) {
+            return 0;
+        }
+
+        sourcePosition += numSamples;
+        return numSamples;
+    }
+
+    // Sample rate conversion: read a little more source than needed and only
+    // advance by what the interpolators actually consumed
+    const int numSource = juce::jmin(sourceBuffer.getNumSamples(),
+                                     static_cast<int>(std::ceil(numSamples * producerRatio)) + 4);
+
+    if (!reader->read(sourceBuffer.getArrayOfWritePointers(), numChannels, sourcePosition, numSource)) {
+        return 0;
+    }
+
+    int consumed = 0;
+    for (int ch = 0; ch < numChannels; ++ch) {
+        consumed = interpolators[static_cast<size_t>(ch)].process(producerRatio,
+                                                                  sourceBuffer.getReadPointer(ch),
+                                                                  chunkBuffer.getWritePointer(ch),
+                                                                  numSamples);
+    }
+
+    sourcePosition += consumed;
+    return numSamples;
+}
+
+void DiskStream::writeToRing(juce::int64 outputPosition, const juce::AudioBuffer<float>& source, int numSamples)
+{
+    const int ringStart = static_cast<int>(outputPosition % capacity);
+    const int firstPart = juce::jmin(numSamples, capacity - ringStart);
+    const int secondPart = numSamples - firstPart;
+
+    for (int ch = 0; ch < numChannels; ++ch) {
+        ring.copyFrom(ch, ringStart, source, ch, 0, firstPart);
+        if (secondPart > 0) {
+            ring.copyFrom(ch, 0, source, ch, firstPart, secondPart);
+        }
+    }
+}
+
+//==============================================================================
+// DiskStreamer
+//==============================================================================
+
+DiskStreamer::Worker::Worker(int index)
+    : juce::Thread("CueForge Disk I/O " + juce::String(index + 1))
+{
+}
+
+DiskStreamer::Worker::~Worker()
+{
+    stopThread(2000);
+}
+
+void DiskStreamer::Worker::run()
+{
+    while (!threadShouldExit()) {
+        if (!serviceStreams()) {
+            wait(IDLE_WAIT_MS);
+        }
+    }
+}
+
+bool DiskStreamer::Worker::serviceStreams()
+{
+    juce::ScopedLock lock(streamLock);
+
+    bool didWork = false;
+    for (auto* stream : streams) {
+        didWork = stream->service() || didWork;
+    }
+    return didWork;
+}
+
+DiskStreamer::DiskStreamer(int numThreads)
+{
+    for (int i = 0; i < juce::jmax(1, numThreads); ++i) {
+        workers.push_back(std::make_unique<Worker>(i));
+        workers.back()->startThread(juce::Thread::Priority::high);
+    }
+}
+
+DiskStreamer::~DiskStreamer()
+{
+    for (auto& worker : workers) {
+        worker->signalThreadShouldExit();
+        worker->notify();
+    }
+    workers.clear();
+}
+
+void DiskStreamer::addStream(DiskStream* stream)
+{
+    if (stream == nullptr || workers.empty()) {
+        return;
+    }
+
+    // Give the stream to the least busy worker
+    Worker* target = nullptr;
+    size_t fewestStreams = 0;
+    for (auto& worker : workers) {
+        juce::ScopedLock lock(worker->streamLock);
+        if (target == nullptr || worker->streams.size() < fewestStreams) {
+            target = worker.get();
+            fewestStreams = worker->streams.size();
+        }
+    }
+
+    {
+        juce::ScopedLock lock(target->streamLock);
+        target->streams.push_back(stream);
+    }
+    target->notify();
+}
+
+void DiskStreamer::removeStream(DiskStream* stream)
+{
+    // Taking the worker's lock guarantees it is not inside stream->service()
+    for (auto& worker : workers) {
+        juce::ScopedLock lock(worker->streamLock);
+        auto& streams = worker->streams;
+        streams.erase(std::remove(streams.begin(), streams.end(), stream), streams.end());
+    }
+}
+
+void DiskStreamer::wakeUp()
+{
+    for (auto& worker : workers) {
+        worker->notify();
+    }
+}
+
+int DiskStreamer::getNumStreams() const
+{
+    int total = 0;
+    for (auto& worker : workers) {
+        juce::ScopedLock lock(worker->streamLock);
+        total += static_cast<int>(worker->streams.size());
+    }
+    return total;
+}
@@ -0,0 +1,214 @@
+#include "../include/FadeEngine.h"
+
+#include <cmath>
+
+namespace
+{
+    // Floor for the exponential law, which cannot reach zero (-100 dB)
+    constexpr float EXPONENTIAL_FLOOR = 0.00001f;
+}
+
+FadeEngine::FadeEngine()
+{
+}
+
+FadeEngine::~FadeEngine()
+{
+}
+
+void FadeEngine::prepare(int maximumBlockSize)
+{
+    const int size = juce::jmax(1, maximumBlockSize);
+    if (size > gainCapacity) {
+        gains.allocate(static_cast<size_t>(size), true);
+        sampleIndices.allocate(static_cast<size_t>(size), false);
+        for (int i = 0; i < size; ++i) {
+            sampleIndices[i] = static_cast<float>(i);
+        }
+        gainCapacity = size;
+    }
+}
+
+void FadeEngine::startFade(float newTarget, int lengthInSamples, FadeCurve curve)
+{
+    // Start from wherever the gain is now so interrupted fades never click
+    startLevel = currentLevel;
+    targetLevel = newTarget;
+    fadeCurve = curve;
+    fadePosition = 0;
+    fadeLength = juce::jmax(0, lengthInSamples);
+
+    if (fadeLength == 0) {
+        currentLevel = targetLevel;
+    }
+}
+
+void FadeEngine::setLevel(float level)
+{
+    currentLevel = level;
+    startLevel = level;
+    targetLevel = level;
+    fadeLength = 0;
+    fadePosition = 0;
+}
+
+void FadeEngine::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    if (numSamples <= 0) {
+        return;
+    }
+
+    // Steady state: a single gain (or nothing at unity)
+    if (!isFading() || gainCapacity == 0) {
+        if (isFading()) {
+            // Not prepared: jump rather than allocate on the audio thread
+            setLevel(targetLevel);
+        }
+
+        if (currentLevel != 1.0f) {
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch) {
+                buffer.applyGain(ch, startSample, numSamples, currentLevel);
+            }
+        }
+        return;
+    }
+
+    // Render the ramp once per chunk, then apply it to every channel
+    int done = 0;
+    while (done < numSamples) {
+        const int chunk = juce::jmin(numSamples - done, gainCapacity);
+        const int ramped = renderGains(chunk);
+
+        // Past the end of the ramp the gain holds at the target
+        if (ramped < chunk) {
+            juce::FloatVectorOperations::fill(gains.get() + ramped, targetLevel, chunk - ramped);
+        }
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch) {
+            juce::FloatVectorOperations::multiply(buffer.getWritePointer(ch, startSample + done),
+                                                  gains.get(), chunk);
+        }
+
+        done += chunk;
+    }
+}
+
+int FadeEngine::renderGains(int numSamples)
+{
+    const int ramped = juce::jmin(numSamples, fadeLength - fadePosition);
+    const float invLength = 1.0f / static_cast<float>(fadeLength);
+
+    if (fadeCurve == FadeCurve::linear) {
+        // Linear ramps are an arithmetic series: no per-sample curve evaluation
+        const float step = (targetLevel - startLevel) * invLength;
+        float level = startLevel + step * static_cast<float>(fadePosition + 1);
+        for (int i = 0; i < ramped; ++i) {
+            gains[i] = level;
+            level += step;
+        }
+    } else {
+        // Shaped curves go segment by segment; segments are fixed fractions of
+        // the fade, so the approximation doesn't depend on the block size
+        const int segmentLength = juce::jmax(1, (fadeLength + CURVE_SEGMENTS - 1) / CURVE_SEGMENTS);
+        int done = 0;
+        while (done < ramped) {
+            const int firstSample = fadePosition + done;
+            const int segmentEnd = (firstSample / segmentLength + 1) * segmentLength;
+            const int count = juce::jmin(ramped - done, segmentEnd - firstSample);
+            renderCurveSegment(gains.get() + done, firstSample, count);
+            done += count;
+        }
+    }
+
+    fadePosition += ramped;
+    if (fadePosition >= fadeLength) {
+        setLevel(targetLevel);
+    } else if (ramped > 0) {
+        currentLevel = gains[ramped - 1];
+    }
+
+    return ramped;
+}
+
+void FadeEngine::renderCurveSegment(float* destination, int firstSample, int numSamples)
+{
+    // Sample i of the segment sits at ramp position (firstSample + i + 1) / fadeLength
+    const float invLength = 1.0f / static_cast<float>(fadeLength);
+    auto at = [&](float i) {
+        return shape(fadeCurve, startLevel, targetLevel, (static_cast<float>(firstSample) + i + 1.0f) * invLength);
+    };
+
+    const float first = at(0.0f);
+    if (numSamples < 3) {
+        destination[0] = first;
+        if (numSamples == 2) {
+            destination[1] = at(1.0f);
+        }
+        return;
+    }
+
+    // Quadratic a + b*i + c*i^2 through the first, middle and last samples
+    const float half = 0.5f * static_cast<float>(numSamples - 1);
+    const float middle = at(half);
+    const float last = at(2.0f * half);
+    const float c = (first - 2.0f * middle + last) / (2.0f * half * half);
+    const float b = (middle - first) / half - c * half;
+
+    // Horner form, all vector operations: (c*i + b)*i + a
+    juce::FloatVectorOperations::copy(destination, sampleIndices.get(), numSamples);
+    juce::FloatVectorOperations::multiply(destination, c, numSamples);
+    juce::FloatVectorOperations::add(destination, b, numSamples);
+    juce::FloatVectorOperations::multiply(destination, sampleIndices.get(), numSamples);
+    juce::FloatVectorOperations::add(destination, first, numSamples);
+}
+
+float FadeEngine::shape(FadeCurve curve, float from, float to, float position)
+{
+    const float t = juce::jlimit(0.0f, 1.0f, position);
+    const float range = to - from;
+
+    switch (curve) {
+        case FadeCurve::equalPower: {
+            // Rising: sin law; falling: cos law, so a crossfade sums to constant power
+            const float angle = t * juce::MathConstants<float>::halfPi;
+            return range >= 0.0f ? from + range * std::sin(angle)
+                                 : to - range * std::cos(angle);
+        }
+
+        case FadeCurve::sCurve:
+            return from + range * (t * t * (3.0f - 2.0f * t));
+
+        case FadeCurve::logarithmic:
+            return from + range * std::log10(1.0f + 9.0f * t);
+
+        case FadeCurve::exponential: {
+            const float safeFrom = juce::jmax(from, EXPONENTIAL_FLOOR);
+            const float safeTo = juce::jmax(to, EXPONENTIAL_FLOOR);
+            if (t >= 1.0f) {
+                return to;
+            }
+            return safeFrom * std::pow(safeTo / safeFrom, t);
+        }
+
+        case FadeCurve::linear:
+        default:
+            return from + range * t;
+    }
+}
+
+FadeCurve FadeEngine::curveFromString(const juce::String& name)
+{
+    if (name == "equal-power" || name == "equalPower") {
+        return FadeCurve::equalPower;
+    }
+    if (name == "s-curve" || name == "sCurve") {
+        return FadeCurve::sCurve;
+    }
+    if (name == "logarithmic") {
+        return FadeCurve::logarithmic;
+    }
+    if (name == "exponential") {
+        return FadeCurve::exponential;
+    }
+    return FadeCurve::linear;
+}
@@ -0,0 +1,130 @@
+#include "../include/LatencyHistogram.h"
+
+#include <cmath>
+#include <iterator>
+
+int LatencyHistogram::getBucketIndex(juce::int64 nanoseconds) noexcept
+{
+    const auto value = static_cast<juce::uint64>(juce::jlimit<juce::int64>(0, MAX_NANOSECONDS, nanoseconds));
+    if (value < static_cast<juce::uint64>(SUB_BUCKETS)) {
+        return static_cast<int>(value);
+    }
+
+    int magnitude = SUB_BUCKET_BITS;
+    while ((value >> (magnitude + 1)) != 0) {
+        ++magnitude;
+    }
+
+    // The top SUB_BUCKET_BITS + 1 bits pick the sub-bucket within the power of two
+    const int subBucket = static_cast<int>(value >> (magnitude - SUB_BUCKET_BITS)) - SUB_BUCKETS;
+    return SUB_BUCKETS * (magnitude - SUB_BUCKET_BITS + 1) + subBucket;
+}
+
+juce::int64 LatencyHistogram::getBucketLowerBound(int bucket)
+{
+    bucket = juce::jlimit(0, NUM_BUCKETS - 1, bucket);
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+
+    const int shift = bucket / SUB_BUCKETS - 1;
+    return static_cast<juce::int64>(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+}
+
+juce::int64 LatencyHistogram::getBucketUpperBound(int bucket)
+{
+    bucket = juce::jlimit(0, NUM_BUCKETS - 1, bucket);
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+
+    const int shift = bucket / SUB_BUCKETS - 1;
+    return getBucketLowerBound(bucket) + (juce::int64(1) << shift) - 1;
+}
+
+void LatencyHistogram::record(juce::int64 nanoseconds) noexcept
+{
+    // Single writer, so plain load/store pairs are enough
+    auto& bucket = buckets[static_cast<size_t>(getBucketIndex(nanoseconds))];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    const auto clamped = static_cast<juce::uint64>(juce::jlimit<juce::int64>(0, MAX_NANOSECONDS, nanoseconds));
+    sumNanoseconds.store(sumNanoseconds.load(std::memory_order_relaxed) + clamped, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::copyCounts(std::vector<juce::uint64>& counts, juce::uint64& totalNanoseconds) const
+{
+    counts.resize(NUM_BUCKETS);
+    for (size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+        const juce::uint64 count = buckets[bucket].load(std::memory_order_relaxed);
+        counts[bucket] = count >= baseline[bucket] ? count - baseline[bucket] : 0;
+    }
+
+    const juce::uint64 sum = sumNanoseconds.load(std::memory_order_relaxed);
+    totalNanoseconds = sum >= baselineSum ? sum - baselineSum : 0;
+}
+
+void LatencyHistogram::getCounts(std::vector<juce::uint64>& counts) const
+{
+    const juce::ScopedLock lock(baselineLock);
+    juce::uint64 totalNanoseconds = 0;
+    copyCounts(counts, totalNanoseconds);
+}
+
+LatencyHistogram::Summary LatencyHistogram::getSummary() const
+{
+    std::vector<juce::uint64> counts;
+    juce::uint64 totalNanoseconds = 0;
+    {
+        const juce::ScopedLock lock(baselineLock);
+        copyCounts(counts, totalNanoseconds);
+    }
+
+    Summary summary;
+    juce::uint64 total = 0;
+    for (const auto count : counts) {
+        total += count;
+    }
+    if (total == 0) {
+        return summary;
+    }
+
+    summary.count = static_cast<juce::int64>(total);
+    summary.meanUs = static_cast<double>(totalNanoseconds) / static_cast<double>(total) / 1000.0;
+
+    // Percentiles report the top of their bucket, so they never understate
+    const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    double* results[] = { &summary.p50Us, &summary.p90Us, &summary.p99Us, &summary.p999Us };
+    size_t nextQuantile = 0;
+    juce::uint64 seen = 0;
+    bool foundMin = false;
+
+    for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+        const juce::uint64 count = counts[static_cast<size_t>(bucket)];
+        if (count == 0) {
+            continue;
+        }
+        if (!foundMin) {
+            summary.minUs = getBucketLowerBound(bucket) / 1000.0;
+            foundMin = true;
+        }
+
+        seen += count;
+        while (nextQuantile < std::size(quantiles)
+               && static_cast<double>(seen) >= std::ceil(quantiles[nextQuantile] * static_cast<double>(total))) {
+            *results[nextQuantile++] = getBucketUpperBound(bucket) / 1000.0;
+        }
+        summary.maxUs = getBucketUpperBound(bucket) / 1000.0;
+    }
+
+    return summary;
+}
+
+void LatencyHistogram::reset()
+{
+    const juce::ScopedLock lock(baselineLock);
+    for (size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+        baseline[bucket] = buckets[bucket].load(std::memory_order_relaxed);
+    }
+    baselineSum = sumNanoseconds.load(std::memory_order_relaxed);
+}
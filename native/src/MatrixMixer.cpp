@@ -2,81 +2,207 @@
 #include <juce_data_structures/juce_data_structures.h>
 #include <juce_audio_basics/juce_audio_basics.h>
 
-MatrixMixer::MatrixMixer()
+#include <algorithm>
+
+MatrixMixer::MatrixMixer(int numInputs, int numOutputs)
+{
+    configure(numInputs, numOutputs, OutputPatch::DEFAULT_DEVICE_OUTPUTS);
+    prepare(currentSampleRate.load(), 512);
+}
+
+MatrixMixer::~MatrixMixer()
+{
+}
+
+void MatrixMixer::configure(int numInputs, int numOutputs, int maxFusedOutputs)
 {
-    // Initialize all crosspoints to zero
-    for (int input = 0; input < MAX_INPUTS; ++input) {
-        for (int output = 0; output < MAX_OUTPUTS; ++output) {
-            crosspoints[input][output].store(0.0f);
+    numInputs = juce::jlimit(1, MAX_CHANNELS, numInputs);
+    numOutputs = juce::jlimit(1, MAX_CHANNELS, numOutputs);
+    maxFusedOutputs = juce::jlimit(1, MAX_CHANNELS, maxFusedOutputs);
+    
+    const juce::ScopedLock lock(routeLock);
+    
+    // New storage: silent crosspoints, unity levels
+    std::vector<std::atomic<float>> newCrosspoints(static_cast<size_t>(numInputs * numOutputs));
+    std::vector<std::atomic<float>> newInputLevels(static_cast<size_t>(numInputs));
+    std::vector<std::atomic<bool>> newInputMutes(static_cast<size_t>(numInputs));
+    std::vector<std::atomic<float>> newOutputLevels(static_cast<size_t>(numOutputs));
+    std::vector<std::atomic<bool>> newOutputMutes(static_cast<size_t>(numOutputs));
+    std::vector<std::atomic<bool>> newOutputSolos(static_cast<size_t>(numOutputs));
+    
+    for (int input = 0; input < numInputs; ++input) {
+        for (int output = 0; output < numOutputs; ++output) {
+            const bool kept = input < numInputChannels && output < numOutputChannels;
+            newCrosspoints[static_cast<size_t>(input * numOutputs + output)]
+                .store(kept ? crosspoints[crosspointIndex(input, output)].load() : 0.0f);
         }
-        inputLevels[input].store(1.0f);
-        inputMutes[input].store(false);
+        newInputLevels[static_cast<size_t>(input)].store(input < numInputChannels ? inputLevels[input].load() : 1.0f);
+        newInputMutes[static_cast<size_t>(input)].store(input < numInputChannels && inputMutes[input].load());
     }
     
-    for (int output = 0; output < MAX_OUTPUTS; ++output) {
-        outputLevels[output].store(1.0f);
-        outputMutes[output].store(false);
-        outputSolos[output].store(false);
+    for (int output = 0; output < numOutputs; ++output) {
+        const bool kept = output < numOutputChannels;
+        newOutputLevels[static_cast<size_t>(output)].store(kept ? outputLevels[output].load() : 1.0f);
+        newOutputMutes[static_cast<size_t>(output)].store(kept && outputMutes[output].load());
+        newOutputSolos[static_cast<size_t>(output)].store(kept && outputSolos[output].load());
     }
+    
+    crosspoints = std::move(newCrosspoints);
+    inputLevels = std::move(newInputLevels);
+    inputMutes = std::move(newInputMutes);
+    outputLevels = std::move(newOutputLevels);
+    outputMutes = std::move(newOutputMutes);
+    outputSolos = std::move(newOutputSolos);
+    numInputChannels = numInputs;
+    numOutputChannels = numOutputs;
+    maxFusedOutputChannels = maxFusedOutputs;
+    updateSoloState();
+    inputMeters.configure(numInputs);
+    outputMeters.configure(numOutputs);
+    
+    // Audio-thread state starts over; every route comes back at its full gain
+    routeStride = juce::jmax(numOutputs, maxFusedOutputs);
+    const size_t numSlots = static_cast<size_t>(numInputs * routeStride);
+    routeGains.assign(numSlots, 0.0f);
+    routeStamps.assign(numSlots, 0);
+    activeRoutes.clear();
+    activeRoutes.reserve(numSlots);
+    nextActiveRoutes.clear();
+    nextActiveRoutes.reserve(numSlots);
+    steadyGroups.reserve(numSlots);
+    steadyTaps.reserve(numSlots);
+    lastRouteSequence = 0;
+    lastRoutesFused = false;
+    
+    scratchBusRoutes.clear();
+    scratchBusRoutes.reserve(static_cast<size_t>(numInputs * numOutputs));
+    scratchOutputLevels.assign(static_cast<size_t>(numOutputs), 0.0f);
+    scratchDeviceGains.assign(static_cast<size_t>(maxFusedOutputs), 0.0f);
+    scratchDevices.clear();
+    scratchDevices.reserve(static_cast<size_t>(maxFusedOutputs));
+    bucketFusedPatch();
+    
+    rebuildRoutes();
 }
 
-MatrixMixer::~MatrixMixer()
+void MatrixMixer::prepare(double sampleRate, int maxBlockSize)
+{
+    currentSampleRate.store(sampleRate);
+    inputMeters.prepare(sampleRate);
+    outputMeters.prepare(sampleRate);
+    
+    // Resolve the kernel's ISA choice here rather than on the first callback
+    MixKernel::getImplementationName();
+    
+    // Scratch for one ramp chunk; longer blocks are ramped in several chunks
+    rampCapacity = juce::jmax(1, maxBlockSize);
+    rampIndex.allocate(static_cast<size_t>(rampCapacity), false);
+    rampGains.allocate(static_cast<size_t>(rampCapacity), false);
+    for (int i = 0; i < rampCapacity; ++i) {
+        rampIndex[i] = static_cast<float>(i);
+    }
+}
+
+void MatrixMixer::setRampTime(float seconds)
 {
+    rampTime.store(juce::jmax(0.0f, seconds));
 }
 
-void MatrixMixer::processAudioBlock(const float* const* inputBuffers, 
+bool MatrixMixer::processAudioBlock(const float* const* inputBuffers, 
                                   float* const* outputBuffers,
                                   int numInputs, 
                                   int numOutputs, 
-                                  int numSamples)
+                                  int numSamples,
+                                  float* const* fusedBuffers,
+                                  int numFusedOutputs)
 {
+    // Pick up a newly compiled route list and retarget the affected gains
+    const RouteList* list = acquireRoutes();
+    if (list != nullptr && list->sequence != lastRouteSequence) {
+        syncActiveRoutes(*list);
+        lastRouteSequence = list->sequence;
+    }
+    
+    const bool fused = lastRoutesFused && fusedBuffers != nullptr;
+    if (fused) {
+        outputBuffers = fusedBuffers;
+        numOutputs = numFusedOutputs;
+    }
+    
     // Clear output buffers
     for (int output = 0; output < numOutputs; ++output) {
         juce::FloatVectorOperations::clear(outputBuffers[output], numSamples);
     }
     
-    // Process matrix mixing
-    for (int output = 0; output < juce::jmin(numOutputs, MAX_OUTPUTS); ++output) {
-        if (!shouldOutputBeActive(output)) {
-            continue;
-        }
+    for (auto& route : activeRoutes) {
+        float& gain = routeGains[routeSlot(route.input, route.output)];
+        const bool audible = route.input < numInputs && route.output < numOutputs;
         
-        float outputLevel = outputLevels[output].load();
-        
-        for (int input = 0; input < juce::jmin(numInputs, MAX_INPUTS); ++input) {
-            float crosspoint = crosspoints[input][output].load();
-            if (crosspoint <= SILENCE_THRESHOLD) {
-                continue;
+        if (route.remaining > 0) {
+            const int rampLength = juce::jmin(route.remaining, numSamples);
+            if (audible) {
+                addRamped(outputBuffers[route.output], inputBuffers[route.input], gain, route.step, rampLength);
             }
             
-            float inputLevel = inputLevels[input].load();
-            bool inputMuted = inputMutes[input].load();
+            route.remaining -= rampLength;
+            gain = route.remaining == 0 ? route.target : gain + route.step * static_cast<float>(rampLength);
             
-            if (inputMuted) {
-                continue;
+            // The ramp finished inside this block; hold the target for the rest
+            if (audible && rampLength < numSamples && gain != 0.0f) {
+                juce::FloatVectorOperations::addWithMultiply(outputBuffers[route.output] + rampLength, 
+                                                            inputBuffers[route.input] + rampLength, 
+                                                            gain, 
+                                                            numSamples - rampLength);
             }
-            
-            float gain = crosspoint * inputLevel * outputLevel;
-            
-            juce::FloatVectorOperations::addWithMultiply(outputBuffers[output], 
-                                                        inputBuffers[input], 
-                                                        gain, 
-                                                        numSamples);
         }
+        else if (audible && gain != 0.0f) {
+            // Steady routes are batched per input for the tiled kernel
+            if (steadyGroups.empty() || steadyGroups.back().source != inputBuffers[route.input]) {
+                steadyGroups.push_back({inputBuffers[route.input], static_cast<int>(steadyTaps.size()), 0});
+            }
+            steadyTaps.push_back({route.output, gain});
+            ++steadyGroups.back().numTaps;
+        }
+    }
+    
+    MixKernel::process(steadyGroups.data(), static_cast<int>(steadyGroups.size()),
+                       steadyTaps.data(), outputBuffers, numSamples);
+    steadyGroups.clear();
+    steadyTaps.clear();
+    
+    // Meter while the buffers are still hot
+    inputMeters.process(inputBuffers, numInputs, numSamples);
+    if (!fused) {
+        outputMeters.process(outputBuffers, numOutputs, numSamples);
+        outputMetersCleared = false;
+    } else if (!outputMetersCleared) {
+        outputMeters.clear();
+        outputMetersCleared = true;
     }
+    
+    // Drop routes that have finished fading out
+    activeRoutes.erase(std::remove_if(activeRoutes.begin(), activeRoutes.end(),
+                                      [](const ActiveRoute& route) {
+                                          return route.remaining == 0 && route.target == 0.0f;
+                                      }),
+                       activeRoutes.end());
+    
+    audioThreadRoutes.store(nullptr);
+    return fused;
 }
 
 void MatrixMixer::setCrosspoint(int input, int output, float level)
 {
-    if (input >= 0 && input < MAX_INPUTS && output >= 0 && output < MAX_OUTPUTS) {
-        crosspoints[input][output].store(juce::jlimit(0.0f, dBToLinear(MAX_GAIN_DB), level));
+    if (input >= 0 && input < numInputChannels && output >= 0 && output < numOutputChannels) {
+        crosspoints[crosspointIndex(input, output)].store(juce::jlimit(0.0f, dBToLinear(MAX_GAIN_DB), level));
+        rebuildRoutes();
     }
 }
 
 float MatrixMixer::getCrosspoint(int input, int output) const
 {
-    if (input >= 0 && input < MAX_INPUTS && output >= 0 && output < MAX_OUTPUTS) {
-        return crosspoints[input][output].load();
+    if (input >= 0 && input < numInputChannels && output >= 0 && output < numOutputChannels) {
+        return crosspoints[crosspointIndex(input, output)].load();
     }
     return 0.0f;
 }
@@ -88,23 +214,41 @@ void MatrixMixer::clearCrosspoint(int input, int output)
 
 void MatrixMixer::clearAllCrosspoints()
 {
-    for (int input = 0; input < MAX_INPUTS; ++input) {
-        for (int output = 0; output < MAX_OUTPUTS; ++output) {
-            crosspoints[input][output].store(0.0f);
+    for (int input = 0; input < numInputChannels; ++input) {
+        for (int output = 0; output < numOutputChannels; ++output) {
+            crosspoints[crosspointIndex(input, output)].store(0.0f);
+        }
+    }
+    
+    rebuildRoutes();
+}
+
+void MatrixMixer::setCrosspoints(const float* levels, int numInputs, int numOutputs)
+{
+    const float maxGain = dBToLinear(MAX_GAIN_DB);
+    
+    for (int input = 0; input < numInputChannels; ++input) {
+        for (int output = 0; output < numOutputChannels; ++output) {
+            const bool covered = levels != nullptr && input < numInputs && output < numOutputs;
+            const float level = covered ? levels[input * numOutputs + output] : 0.0f;
+            crosspoints[crosspointIndex(input, output)].store(juce::jlimit(0.0f, maxGain, level));
         }
     }
+    
+    rebuildRoutes();
 }
 
 void MatrixMixer::setInputLevel(int input, float level)
 {
-    if (input >= 0 && input < MAX_INPUTS) {
+    if (input >= 0 && input < numInputChannels) {
         inputLevels[input].store(juce::jlimit(0.0f, dBToLinear(MAX_GAIN_DB), level));
+        rebuildRoutes();
     }
 }
 
 float MatrixMixer::getInputLevel(int input) const
 {
-    if (input >= 0 && input < MAX_INPUTS) {
+    if (input >= 0 && input < numInputChannels) {
         return inputLevels[input].load();
     }
     return 0.0f;
@@ -112,14 +256,15 @@ float MatrixMixer::getInputLevel(int input) const
 
 void MatrixMixer::muteInput(int input, bool mute)
 {
-    if (input >= 0 && input < MAX_INPUTS) {
+    if (input >= 0 && input < numInputChannels) {
         inputMutes[input].store(mute);
+        rebuildRoutes();
     }
 }
 
 bool MatrixMixer::isInputMuted(int input) const
 {
-    if (input >= 0 && input < MAX_INPUTS) {
+    if (input >= 0 && input < numInputChannels) {
         return inputMutes[input].load();
     }
     return false;
@@ -127,14 +272,15 @@ bool MatrixMixer::isInputMuted(int input) const
 
 void MatrixMixer::setOutputLevel(int output, float level)
 {
-    if (output >= 0 && output < MAX_OUTPUTS) {
+    if (output >= 0 && output < numOutputChannels) {
         outputLevels[output].store(juce::jlimit(0.0f, dBToLinear(MAX_GAIN_DB), level));
+        rebuildRoutes();
     }
 }
 
 float MatrixMixer::getOutputLevel(int output) const
 {
-    if (output >= 0 && output < MAX_OUTPUTS) {
+    if (output >= 0 && output < numOutputChannels) {
         return outputLevels[output].load();
     }
     return 0.0f;
@@ -142,14 +288,15 @@ float MatrixMixer::getOutputLevel(int output) const
 
 void MatrixMixer::muteOutput(int output, bool mute)
 {
-    if (output >= 0 && output < MAX_OUTPUTS) {
+    if (output >= 0 && output < numOutputChannels) {
         outputMutes[output].store(mute);
+        rebuildRoutes();
     }
 }
 
 bool MatrixMixer::isOutputMuted(int output) const
 {
-    if (output >= 0 && output < MAX_OUTPUTS) {
+    if (output >= 0 && output < numOutputChannels) {
         return outputMutes[output].load();
     }
     return false;
@@ -157,15 +304,16 @@ bool MatrixMixer::isOutputMuted(int output) const
 
 void MatrixMixer::soloOutput(int output, bool solo)
 {
-    if (output >= 0 && output < MAX_OUTPUTS) {
+    if (output >= 0 && output < numOutputChannels) {
         outputSolos[output].store(solo);
         updateSoloState();
+        rebuildRoutes();
     }
 }
 
 bool MatrixMixer::isOutputSoloed(int output) const
 {
-    if (output >= 0 && output < MAX_OUTPUTS) {
+    if (output >= 0 && output < numOutputChannels) {
         return outputSolos[output].load();
     }
     return false;
@@ -173,16 +321,20 @@ bool MatrixMixer::isOutputSoloed(int output) const
 
 void MatrixMixer::setInputGang(const std::vector<int>& inputs, float level)
 {
+    beginUpdate();
     for (int input : inputs) {
         setInputLevel(input, level);
     }
+    endUpdate();
 }
 
 void MatrixMixer::setOutputGang(const std::vector<int>& outputs, float level)
 {
+    beginUpdate();
     for (int output : outputs) {
         setOutputLevel(output, level);
     }
+    endUpdate();
 }
 
 void MatrixMixer::saveState(juce::ValueTree& state) const
@@ -197,20 +349,77 @@ void MatrixMixer::loadState(const juce::ValueTree& state)
 
 void MatrixMixer::resetToDefault()
 {
+    beginUpdate();
     clearAllCrosspoints();
     
-    for (int i = 0; i < MAX_INPUTS; ++i) {
+    for (int i = 0; i < numInputChannels; ++i) {
         inputLevels[i].store(1.0f);
         inputMutes[i].store(false);
     }
     
-    for (int i = 0; i < MAX_OUTPUTS; ++i) {
+    for (int i = 0; i < numOutputChannels; ++i) {
         outputLevels[i].store(1.0f);
         outputMutes[i].store(false);
         outputSolos[i].store(false);
     }
     
     hasSoloActive.store(false);
+    rebuildRoutes();
+    endUpdate();
+}
+
+void MatrixMixer::captureControls(Controls& controls) const
+{
+    controls.crosspoints.resize(crosspoints.size());
+    for (size_t i = 0; i < crosspoints.size(); ++i) {
+        controls.crosspoints[i] = crosspoints[i].load();
+    }
+    
+    controls.inputLevels.resize(inputLevels.size());
+    controls.inputMutes.resize(inputMutes.size());
+    for (size_t i = 0; i < inputLevels.size(); ++i) {
+        controls.inputLevels[i] = inputLevels[i].load();
+        controls.inputMutes[i] = inputMutes[i].load();
+    }
+    
+    controls.outputLevels.resize(outputLevels.size());
+    controls.outputMutes.resize(outputMutes.size());
+    controls.outputSolos.resize(outputSolos.size());
+    for (size_t i = 0; i < outputLevels.size(); ++i) {
+        controls.outputLevels[i] = outputLevels[i].load();
+        controls.outputMutes[i] = outputMutes[i].load();
+        controls.outputSolos[i] = outputSolos[i].load();
+    }
+}
+
+void MatrixMixer::restoreControls(const Controls& controls)
+{
+    // A capture from before a configure() no longer lines up with the matrix
+    if (controls.crosspoints.size() != crosspoints.size()
+        || controls.inputLevels.size() != inputLevels.size()
+        || controls.outputLevels.size() != outputLevels.size()) {
+        return;
+    }
+    
+    beginUpdate();
+    for (size_t i = 0; i < crosspoints.size(); ++i) {
+        crosspoints[i].store(controls.crosspoints[i]);
+    }
+    
+    for (size_t i = 0; i < inputLevels.size(); ++i) {
+        inputLevels[i].store(controls.inputLevels[i]);
+        inputMutes[i].store(controls.inputMutes[i]);
+    }
+    
+    for (size_t i = 0; i < outputLevels.size(); ++i) {
+        outputLevels[i].store(controls.outputLevels[i]);
+        outputMutes[i].store(controls.outputMutes[i]);
+        outputSolos[i].store(controls.outputSolos[i]);
+    }
+    
+    updateSoloState();
+    rebuildRoutes();
+    endUpdate();
 }
 
 float MatrixMixer::dBToLinear(float dB)
@@ -226,7 +435,7 @@ float MatrixMixer::linearToDb(float linear)
 void MatrixMixer::updateSoloState()
 {
     bool anySolo = false;
-    for (int i = 0; i < MAX_OUTPUTS; ++i) {
+    for (int i = 0; i < numOutputChannels; ++i) {
         if (outputSolos[i].load()) {
             anySolo = true;
             break;
@@ -235,6 +444,295 @@ void MatrixMixer::updateSoloState()
     hasSoloActive.store(anySolo);
 }
 
+void MatrixMixer::beginUpdate()
+{
+    const juce::ScopedLock lock(routeLock);
+    ++updateDepth;
+}
+
+void MatrixMixer::endUpdate()
+{
+    const juce::ScopedLock lock(routeLock);
+    if (updateDepth > 0 && --updateDepth == 0 && routesPending) {
+        rebuildRoutes();
+    }
+}
+
+void MatrixMixer::postCrosspoint(int input, int output, float level)
+{
+    if (input >= 0 && input < numInputChannels && output >= 0 && output < numOutputChannels) {
+        crosspoints[crosspointIndex(input, output)].store(juce::jlimit(0.0f, dBToLinear(MAX_GAIN_DB), level));
+        routesPosted.store(true);
+    }
+}
+
+void MatrixMixer::postInputLevel(int input, float level, bool mute)
+{
+    if (input >= 0 && input < numInputChannels) {
+        inputLevels[input].store(juce::jlimit(0.0f, dBToLinear(MAX_GAIN_DB), level));
+        inputMutes[input].store(mute);
+        routesPosted.store(true);
+    }
+}
+
+void MatrixMixer::postOutputLevel(int output, float level)
+{
+    if (output >= 0 && output < numOutputChannels) {
+        outputLevels[output].store(juce::jlimit(0.0f, dBToLinear(MAX_GAIN_DB), level));
+        routesPosted.store(true);
+    }
+}
+
+bool MatrixMixer::commitPostedChanges()
+{
+    if (!routesPosted.load()) {
+        return false;
+    }
+    
+    rebuildRoutes();
+    return true;
+}
+
+void MatrixMixer::rebuildRoutes()
+{
+    const juce::ScopedLock lock(routeLock);
+    
+    if (updateDepth > 0) {
+        routesPending = true;
+        return;
+    }
+    routesPending = false;
+    
+    // Everything posted so far is read below, so this rebuild covers it
+    routesPosted.store(false);
+    
+    // Input-major, so the kernel can feed all of an input's outputs from one load
+    for (int output = 0; output < numOutputChannels; ++output) {
+        scratchOutputLevels[static_cast<size_t>(output)] = shouldOutputBeActive(output) ? outputLevels[output].load() : 0.0f;
+    }
+    
+    // Fused lists are multiplied through the patch, so the bus routes are only scratch
+    const bool fuse = patchFused.load();
+    auto list = std::make_unique<RouteList>();
+    auto& busRoutes = fuse ? scratchBusRoutes : list->routes;
+    busRoutes.clear();
+    
+    for (int input = 0; input < numInputChannels; ++input) {
+        if (inputMutes[input].load()) {
+            continue;
+        }
+        
+        const float inputLevel = inputLevels[input].load();
+        
+        for (int output = 0; output < numOutputChannels; ++output) {
+            const float crosspoint = crosspoints[crosspointIndex(input, output)].load();
+            if (crosspoint <= SILENCE_THRESHOLD) {
+                continue;
+            }
+            
+            const float gain = crosspoint * inputLevel * scratchOutputLevels[static_cast<size_t>(output)];
+            if (gain > 0.0f) {
+                busRoutes.push_back({input, output, gain});
+            }
+        }
+    }
+    
+    if (fuse) {
+        // Multiply through the patch: input -> bus -> device becomes input ->
+        // device. One input's device gains are summed in a scratch row, and
+        // only the devices it touched are emitted and cleared
+        size_t next = 0;
+        while (next < busRoutes.size()) {
+            const int input = busRoutes[next].input;
+            
+            for (; next < busRoutes.size() && busRoutes[next].input == input; ++next) {
+                const Route& route = busRoutes[next];
+                const int firstTap = fusedPatchStart[static_cast<size_t>(route.output)];
+                const int endTap = fusedPatchStart[static_cast<size_t>(route.output + 1)];
+                
+                for (int tap = firstTap; tap < endTap; ++tap) {
+                    const auto& patch = fusedPatch[static_cast<size_t>(tap)];
+                    float& gain = scratchDeviceGains[static_cast<size_t>(patch.deviceOutput)];
+                    if (gain == 0.0f) {
+                        scratchDevices.push_back(patch.deviceOutput);
+                    }
+                    gain += route.gain * patch.gain;
+                }
+            }
+            
+            std::sort(scratchDevices.begin(), scratchDevices.end());
+            for (const int device : scratchDevices) {
+                float& gain = scratchDeviceGains[static_cast<size_t>(device)];
+                if (gain > 0.0f) {
+                    list->routes.push_back({input, device, gain});
+                }
+                gain = 0.0f;
+            }
+            scratchDevices.clear();
+        }
+        list->fused = true;
+    }
+    
+    list->sequence = ++nextRouteSequence;
+    publishedRoutes.store(list.get());
+    if (currentRoutes) {
+        retiredRoutes.push_back(std::move(currentRoutes));
+    }
+    currentRoutes = std::move(list);
+    
+    reclaimRoutes();
+}
+
+void MatrixMixer::setFusedPatch(std::vector<OutputPatch::Route> patchRoutes)
+{
+    {
+        const juce::ScopedLock lock(routeLock);
+        fusedPatch = std::move(patchRoutes);
+        bucketFusedPatch();
+        patchFused.store(true);
+    }
+    rebuildRoutes();
+}
+
+void MatrixMixer::clearFusedPatch()
+{
+    {
+        const juce::ScopedLock lock(routeLock);
+        fusedPatch.clear();
+        bucketFusedPatch();
+        patchFused.store(false);
+    }
+    rebuildRoutes();
+}
+
+void MatrixMixer::bucketFusedPatch()
+{
+    // Called with routeLock held. Drops taps outside the current channel
+    // counts, then groups the rest by mixer output so a rebuild visits only
+    // the taps each route feeds
+    fusedPatch.erase(std::remove_if(fusedPatch.begin(), fusedPatch.end(),
+                                    [this](const OutputPatch::Route& patch) {
+                                        return patch.cueOutput < 0 || patch.cueOutput >= numOutputChannels
+                                            || patch.deviceOutput < 0 || patch.deviceOutput >= maxFusedOutputChannels
+                                            || patch.gain <= 0.0f;
+                                    }),
+                     fusedPatch.end());
+    std::stable_sort(fusedPatch.begin(), fusedPatch.end(),
+                     [](const OutputPatch::Route& a, const OutputPatch::Route& b) {
+                         return a.cueOutput < b.cueOutput;
+                     });
+    
+    fusedPatchStart.assign(static_cast<size_t>(numOutputChannels + 1), 0);
+    for (const auto& patch : fusedPatch) {
+        ++fusedPatchStart[static_cast<size_t>(patch.cueOutput + 1)];
+    }
+    for (size_t output = 1; output < fusedPatchStart.size(); ++output) {
+        fusedPatchStart[output] += fusedPatchStart[output - 1];
+    }
+}
+
+void MatrixMixer::reclaimRoutes()
+{
+    // Called with routeLock held
+    RouteList* inUse = audioThreadRoutes.load();
+    
+    retiredRoutes.erase(std::remove_if(retiredRoutes.begin(), retiredRoutes.end(),
+                                       [inUse](const std::unique_ptr<RouteList>& list) {
+                                           return list.get() != inUse;
+                                       }),
+                        retiredRoutes.end());
+}
+
+const MatrixMixer::RouteList* MatrixMixer::acquireRoutes()
+{
+    // Same announce-and-recheck handshake as AudioEngine::acquireCueSnapshot
+    RouteList* list = publishedRoutes.load();
+    for (;;) {
+        audioThreadRoutes.store(list);
+        RouteList* latest = publishedRoutes.load();
+        if (latest == list) {
+            return list;
+        }
+        list = latest;
+    }
+}
+
+void MatrixMixer::syncActiveRoutes(const RouteList& list)
+{
+    // Audio thread: every route in the new list ramps to its compiled gain,
+    // every previously active route missing from it ramps to silence
+    const int rampSamples = juce::roundToInt(rampTime.load() * currentSampleRate.load());
+    
+    // Switching between fused and two-stage changes what a route's output
+    // index means, so the old gains cannot ramp into the new ones: snap
+    if (list.fused != lastRoutesFused) {
+        for (const auto& route : activeRoutes) {
+            routeGains[routeSlot(route.input, route.output)] = 0.0f;
+        }
+        activeRoutes.clear();
+        lastRoutesFused = list.fused;
+        
+        for (const auto& route : list.routes) {
+            routeGains[routeSlot(route.input, route.output)] = route.gain;
+            activeRoutes.push_back({route.input, route.output, route.gain, 0.0f, 0});
+        }
+        return;
+    }
+    
+    ++routeGeneration;
+    nextActiveRoutes.clear();
+    
+    for (const auto& route : list.routes) {
+        routeStamps[routeSlot(route.input, route.output)] = routeGeneration;
+        
+        ActiveRoute active{route.input, route.output, 0.0f, 0.0f, 0};
+        retarget(active, route.gain, rampSamples);
+        nextActiveRoutes.push_back(active);
+    }
+    
+    for (auto route : activeRoutes) {
+        if (routeStamps[routeSlot(route.input, route.output)] != routeGeneration) {
+            retarget(route, 0.0f, rampSamples);
+            nextActiveRoutes.push_back(route);
+        }
+    }
+    
+    std::swap(activeRoutes, nextActiveRoutes);
+}
+
+void MatrixMixer::retarget(ActiveRoute& route, float target, int rampSamples)
+{
+    float& gain = routeGains[routeSlot(route.input, route.output)];
+    route.target = target;
+    
+    if (gain == target || rampSamples <= 0) {
+        gain = target;
+        route.step = 0.0f;
+        route.remaining = 0;
+        return;
+    }
+    
+    route.step = (target - gain) / static_cast<float>(rampSamples);
+    route.remaining = rampSamples;
+}
+
+void MatrixMixer::addRamped(float* dest, const float* source, float startGain, float step, int numSamples)
+{
+    // dest += source * (startGain + step * (i + 1)), built a chunk at a time
+    // from the precomputed index ramp so the whole thing stays vectorised
+    float gain = startGain + step;
+    
+    for (int offset = 0; offset < numSamples; offset += rampCapacity) {
+        const int chunk = juce::jmin(rampCapacity, numSamples - offset);
+        
+        juce::FloatVectorOperations::multiply(rampGains.get(), rampIndex.get(), step, chunk);
+        juce::FloatVectorOperations::add(rampGains.get(), gain, chunk);
+        juce::FloatVectorOperations::addWithMultiply(dest + offset, source + offset, rampGains.get(), chunk);
+        
+        gain += step * static_cast<float>(chunk);
+    }
+}
+
 void MatrixMixer::processInput(int inputIndex, const float* inputBuffer, int numSamples)
 {
     // Implementation placeholder for per-input processing
@@ -247,7 +745,7 @@ void MatrixMixer::processOutput(int outputIndex, float* outputBuffer, int numSam
 
 bool MatrixMixer::shouldOutputBeActive(int output) const
 {
-    if (output < 0 || output >= MAX_OUTPUTS) {
+    if (output < 0 || output >= numOutputChannels) {
         return false;
     }
     
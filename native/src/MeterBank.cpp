@@ -0,0 +1,101 @@
+#include "../include/MeterBank.h"
+
+#include <cmath>
+
+void MeterBank::configure(int numChannels)
+{
+    numChannels = juce::jmax(0, numChannels);
+
+    peaks = std::vector<std::atomic<float>>(static_cast<size_t>(numChannels));
+    rmsLevels = std::vector<std::atomic<float>>(static_cast<size_t>(numChannels));
+    holds = std::vector<std::atomic<float>>(static_cast<size_t>(numChannels));
+    meanSquares.assign(static_cast<size_t>(numChannels), 0.0f);
+    holdSamplesLeft.assign(static_cast<size_t>(numChannels), 0);
+
+    for (size_t channel = 0; channel < peaks.size(); ++channel) {
+        peaks[channel].store(0.0f);
+        rmsLevels[channel].store(0.0f);
+        holds[channel].store(0.0f);
+    }
+}
+
+void MeterBank::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+}
+
+void MeterBank::process(const float* const* channels, int numChannels, int numSamples)
+{
+    if (numSamples <= 0) {
+        return;
+    }
+
+    const int channelsToMeter = juce::jmin(numChannels, getNumChannels());
+    const double blockSeconds = numSamples / sampleRate;
+
+    // Per-block ballistics, shared by every channel
+    const float peakDecay = juce::Decibels::decibelsToGain(static_cast<float>(-PEAK_DECAY_DB_PER_SECOND * blockSeconds));
+    const float rmsCoefficient = static_cast<float>(std::exp(-blockSeconds / RMS_WINDOW_SECONDS));
+    const int holdSamples = static_cast<int>(PEAK_HOLD_SECONDS * sampleRate);
+
+    for (int channel = 0; channel < channelsToMeter; ++channel) {
+        const float* samples = channels[channel];
+        const auto slot = static_cast<size_t>(channel);
+
+        const auto range = juce::FloatVectorOperations::findMinAndMax(samples, numSamples);
+        const float blockPeak = juce::jmax(std::abs(range.getStart()), std::abs(range.getEnd()));
+
+        float sumOfSquares = 0.0f;
+        for (int i = 0; i < numSamples; ++i) {
+            sumOfSquares += samples[i] * samples[i];
+        }
+
+        const float peak = juce::jmax(blockPeak, peaks[slot].load(std::memory_order_relaxed) * peakDecay);
+        meanSquares[slot] = rmsCoefficient * meanSquares[slot]
+                          + (1.0f - rmsCoefficient) * (sumOfSquares / static_cast<float>(numSamples));
+
+        float hold = holds[slot].load(std::memory_order_relaxed);
+        if (blockPeak >= hold) {
+            hold = blockPeak;
+            holdSamplesLeft[slot] = holdSamples;
+        } else if ((holdSamplesLeft[slot] -= numSamples) <= 0) {
+            hold = peak;
+            holdSamplesLeft[slot] = 0;
+        }
+
+        peaks[slot].store(peak, std::memory_order_relaxed);
+        rmsLevels[slot].store(std::sqrt(meanSquares[slot]), std::memory_order_relaxed);
+        holds[slot].store(hold, std::memory_order_relaxed);
+    }
+}
+
+void MeterBank::clear()
+{
+    for (size_t channel = 0; channel < peaks.size(); ++channel) {
+        meanSquares[channel] = 0.0f;
+        holdSamplesLeft[channel] = 0;
+        peaks[channel].store(0.0f, std::memory_order_relaxed);
+        rmsLevels[channel].store(0.0f, std::memory_order_relaxed);
+        holds[channel].store(0.0f, std::memory_order_relaxed);
+    }
+}
+
+MeterBank::Level MeterBank::getLevel(int channel) const
+{
+    Level level;
+    if (channel >= 0 && channel < getNumChannels()) {
+        const auto slot = static_cast<size_t>(channel);
+        level.peak = peaks[slot].load(std::memory_order_relaxed);
+        level.rms = rmsLevels[slot].load(std::memory_order_relaxed);
+        level.peakHold = holds[slot].load(std::memory_order_relaxed);
+    }
+    return level;
+}
+
+void MeterBank::getLevels(std::vector<Level>& levels) const
+{
+    levels.resize(peaks.size());
+    for (int channel = 0; channel < getNumChannels(); ++channel) {
+        levels[static_cast<size_t>(channel)] = getLevel(channel);
+    }
+}
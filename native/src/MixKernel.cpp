@@ -0,0 +1,175 @@
+#include "../include/MixKernel.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+#if JUCE_ARM && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+ #include <arm_neon.h>
+ #define MIX_KERNEL_NEON 1
+#else
+ #define MIX_KERNEL_NEON 0
+#endif
+
+// GCC and Clang need the AVX2 function marked so the rest of the file can be
+// built for the baseline ISA; MSVC accepts the intrinsics without it
+#if JUCE_INTEL && (defined(__GNUC__) || defined(__clang__))
+ #define MIX_KERNEL_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+ #define MIX_KERNEL_TARGET_AVX2
+#endif
+
+namespace
+{
+    // dests[k][i] += source[i] * gains[k] for k < numDests (1 to 4)
+    using AccumulateFunction = void (*)(const float* source, float* const* dests,
+                                        const float* gains, int numDests, int numSamples);
+
+    void accumulateScalar(const float* source, float* const* dests,
+                          const float* gains, int numDests, int numSamples)
+    {
+        for (int k = 0; k < numDests; ++k) {
+            float* dest = dests[k];
+            const float gain = gains[k];
+            for (int i = 0; i < numSamples; ++i) {
+                dest[i] += source[i] * gain;
+            }
+        }
+    }
+
+   #if JUCE_INTEL
+    void accumulateSSE2(const float* source, float* const* dests,
+                        const float* gains, int numDests, int numSamples)
+    {
+        __m128 g[4];
+        for (int k = 0; k < numDests; ++k) {
+            g[k] = _mm_set1_ps(gains[k]);
+        }
+
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4) {
+            const __m128 s = _mm_loadu_ps(source + i);
+            for (int k = 0; k < numDests; ++k) {
+                float* d = dests[k] + i;
+                _mm_storeu_ps(d, _mm_add_ps(_mm_loadu_ps(d), _mm_mul_ps(s, g[k])));
+            }
+        }
+
+        for (; i < numSamples; ++i) {
+            for (int k = 0; k < numDests; ++k) {
+                dests[k][i] += source[i] * gains[k];
+            }
+        }
+    }
+
+    MIX_KERNEL_TARGET_AVX2
+    void accumulateAVX2(const float* source, float* const* dests,
+                        const float* gains, int numDests, int numSamples)
+    {
+        __m256 g[4];
+        for (int k = 0; k < numDests; ++k) {
+            g[k] = _mm256_set1_ps(gains[k]);
+        }
+
+        int i = 0;
+        for (; i + 8 <= numSamples; i += 8) {
+            const __m256 s = _mm256_loadu_ps(source + i);
+            for (int k = 0; k < numDests; ++k) {
+                float* d = dests[k] + i;
+                _mm256_storeu_ps(d, _mm256_add_ps(_mm256_loadu_ps(d), _mm256_mul_ps(s, g[k])));
+            }
+        }
+
+        for (; i < numSamples; ++i) {
+            for (int k = 0; k < numDests; ++k) {
+                dests[k][i] += source[i] * gains[k];
+            }
+        }
+    }
+   #endif
+
+   #if MIX_KERNEL_NEON
+    void accumulateNEON(const float* source, float* const* dests,
+                        const float* gains, int numDests, int numSamples)
+    {
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4) {
+            const float32x4_t s = vld1q_f32(source + i);
+            for (int k = 0; k < numDests; ++k) {
+                float* d = dests[k] + i;
+                vst1q_f32(d, vmlaq_n_f32(vld1q_f32(d), s, gains[k]));
+            }
+        }
+
+        for (; i < numSamples; ++i) {
+            for (int k = 0; k < numDests; ++k) {
+                dests[k][i] += source[i] * gains[k];
+            }
+        }
+    }
+   #endif
+
+    struct Implementation
+    {
+        AccumulateFunction accumulate;
+        const char* name;
+    };
+
+    Implementation selectImplementation()
+    {
+       #if JUCE_INTEL
+        if (juce::SystemStats::hasAVX2()) {
+            return {accumulateAVX2, "avx2"};
+        }
+        if (juce::SystemStats::hasSSE2()) {
+            return {accumulateSSE2, "sse2"};
+        }
+       #elif MIX_KERNEL_NEON
+        return {accumulateNEON, "neon"};
+       #endif
+        return {accumulateScalar, "scalar"};
+    }
+
+    const Implementation& getImplementation()
+    {
+        static const Implementation implementation = selectImplementation();
+        return implementation;
+    }
+}
+
+namespace MixKernel
+{
+    void process(const Group* groups, int numGroups, const Tap* taps,
+                 float* const* outputs, int numSamples)
+    {
+        const AccumulateFunction accumulate = getImplementation().accumulate;
+
+        float* dests[4];
+        float gains[4];
+
+        for (int tileStart = 0; tileStart < numSamples; tileStart += TILE_SAMPLES) {
+            const int tileLength = juce::jmin(TILE_SAMPLES, numSamples - tileStart);
+
+            for (int g = 0; g < numGroups; ++g) {
+                const Group& group = groups[g];
+                const float* source = group.source + tileStart;
+
+                // Up to four destinations per pass over the source tile
+                for (int first = 0; first < group.numTaps; first += 4) {
+                    const int numDests = juce::jmin(4, group.numTaps - first);
+                    for (int k = 0; k < numDests; ++k) {
+                        const Tap& tap = taps[group.firstTap + first + k];
+                        dests[k] = outputs[tap.output] + tileStart;
+                        gains[k] = tap.gain;
+                    }
+                    accumulate(source, dests, gains, numDests, tileLength);
+                }
+            }
+        }
+    }
+
+    const char* getImplementationName()
+    {
+        return getImplementation().name;
+    }
+}
@@ -1,26 +1,57 @@
 #include "../include/OutputPatch.h"
 
-OutputPatch::OutputPatch()
+OutputPatch::OutputPatch(int numCueOutputs, int numDeviceOutputs)
 {
-    // Initialize patch matrix to zero
-    for (int cueOutput = 0; cueOutput < MAX_CUE_OUTPUTS; ++cueOutput) {
-        for (int deviceOutput = 0; deviceOutput < MAX_DEVICE_OUTPUTS; ++deviceOutput) {
-            patchMatrix[cueOutput][deviceOutput].store(0.0f);
+    configure(numCueOutputs, numDeviceOutputs);
+    
+    // Set up direct routing by default
+    setDirectRouting();
+}
+
+OutputPatch::~OutputPatch()
+{
+}
+
+void OutputPatch::configure(int numCueOutputs, int numDeviceOutputs)
+{
+    numCueOutputs = juce::jlimit(1, MAX_CHANNELS, numCueOutputs);
+    numDeviceOutputs = juce::jlimit(1, MAX_CHANNELS, numDeviceOutputs);
+    
+    std::vector<std::atomic<float>> newPatch(static_cast<size_t>(numCueOutputs * numDeviceOutputs));
+    std::vector<std::atomic<float>> newLevels(static_cast<size_t>(numDeviceOutputs));
+    std::vector<std::atomic<bool>> newMutes(static_cast<size_t>(numDeviceOutputs));
+    
+    // Keep existing routing where both ends still exist; new points start silent
+    for (int cueOutput = 0; cueOutput < numCueOutputs; ++cueOutput) {
+        for (int deviceOutput = 0; deviceOutput < numDeviceOutputs; ++deviceOutput) {
+            const bool kept = cueOutput < numCueChannels && deviceOutput < numDeviceChannels;
+            newPatch[static_cast<size_t>(cueOutput * numDeviceOutputs + deviceOutput)]
+                .store(kept ? patchMatrix[patchIndex(cueOutput, deviceOutput)].load() : 0.0f);
         }
     }
     
-    // Initialize device output controls
-    for (int deviceOutput = 0; deviceOutput < MAX_DEVICE_OUTPUTS; ++deviceOutput) {
-        deviceOutputLevels[deviceOutput].store(1.0f);
-        deviceOutputMutes[deviceOutput].store(false);
+    for (int deviceOutput = 0; deviceOutput < numDeviceOutputs; ++deviceOutput) {
+        const bool kept = deviceOutput < numDeviceChannels;
+        newLevels[static_cast<size_t>(deviceOutput)].store(kept ? deviceOutputLevels[deviceOutput].load() : 1.0f);
+        newMutes[static_cast<size_t>(deviceOutput)].store(kept && deviceOutputMutes[deviceOutput].load());
     }
     
-    // Set up direct routing by default
-    setDirectRouting();
+    patchMatrix = std::move(newPatch);
+    deviceOutputLevels = std::move(newLevels);
+    deviceOutputMutes = std::move(newMutes);
+    numCueChannels = numCueOutputs;
+    numDeviceChannels = numDeviceOutputs;
+    deviceMeters.configure(numDeviceOutputs);
 }
 
-OutputPatch::~OutputPatch()
+void OutputPatch::prepare(double sampleRate)
 {
+    deviceMeters.prepare(sampleRate);
+}
+
+void OutputPatch::meterDeviceOutputs(const float* const* deviceOutputs, int numDeviceOutputs, int numSamples)
+{
+    deviceMeters.process(deviceOutputs, numDeviceOutputs, numSamples);
 }
 
 void OutputPatch::processAudioBlock(const float* const* cueOutputs,
@@ -35,15 +66,15 @@ void OutputPatch::processAudioBlock(const float* const* cueOutputs,
     }
     
     // Process patch routing
-    for (int deviceOut = 0; deviceOut < juce::jmin(numDeviceOutputs, MAX_DEVICE_OUTPUTS); ++deviceOut) {
+    for (int deviceOut = 0; deviceOut < juce::jmin(numDeviceOutputs, numDeviceChannels); ++deviceOut) {
         if (deviceOutputMutes[deviceOut].load()) {
             continue;
         }
         
         float deviceLevel = deviceOutputLevels[deviceOut].load();
         
-        for (int cueOut = 0; cueOut < juce::jmin(numCueOutputs, MAX_CUE_OUTPUTS); ++cueOut) {
-            float patchLevel = patchMatrix[cueOut][deviceOut].load();
+        for (int cueOut = 0; cueOut < juce::jmin(numCueOutputs, numCueChannels); ++cueOut) {
+            float patchLevel = patchMatrix[patchIndex(cueOut, deviceOut)].load();
             if (patchLevel <= 0.0001f) { // Below threshold
                 continue;
             }
@@ -56,21 +87,50 @@ void OutputPatch::processAudioBlock(const float* const* cueOutputs,
                                                         numSamples);
         }
     }
+    
+    meterDeviceOutputs(deviceOutputs, numDeviceOutputs, numSamples);
+}
+
+std::vector<OutputPatch::Route> OutputPatch::compileRoutes() const
+{
+    std::vector<Route> routes;
+    
+    for (int deviceOut = 0; deviceOut < numDeviceChannels; ++deviceOut) {
+        if (deviceOutputMutes[deviceOut].load()) {
+            continue;
+        }
+        
+        float deviceLevel = deviceOutputLevels[deviceOut].load();
+        
+        for (int cueOut = 0; cueOut < numCueChannels; ++cueOut) {
+            float patchLevel = patchMatrix[patchIndex(cueOut, deviceOut)].load();
+            if (patchLevel <= 0.0001f) { // Same threshold as processAudioBlock
+                continue;
+            }
+            
+            float gain = patchLevel * deviceLevel;
+            if (gain > 0.0f) {
+                routes.push_back({cueOut, deviceOut, gain});
+            }
+        }
+    }
+    
+    return routes;
 }
 
 void OutputPatch::setPatchRouting(int cueOutput, int deviceOutput, float level)
 {
-    if (cueOutput >= 0 && cueOutput < MAX_CUE_OUTPUTS && 
-        deviceOutput >= 0 && deviceOutput < MAX_DEVICE_OUTPUTS) {
-        patchMatrix[cueOutput][deviceOutput].store(juce::jlimit(0.0f, 4.0f, level)); // Max +12dB
+    if (cueOutput >= 0 && cueOutput < numCueChannels && 
+        deviceOutput >= 0 && deviceOutput < numDeviceChannels) {
+        patchMatrix[patchIndex(cueOutput, deviceOutput)].store(juce::jlimit(0.0f, 4.0f, level)); // Max +12dB
     }
 }
 
 float OutputPatch::getPatchRouting(int cueOutput, int deviceOutput) const
 {
-    if (cueOutput >= 0 && cueOutput < MAX_CUE_OUTPUTS && 
-        deviceOutput >= 0 && deviceOutput < MAX_DEVICE_OUTPUTS) {
-        return patchMatrix[cueOutput][deviceOutput].load();
+    if (cueOutput >= 0 && cueOutput < numCueChannels && 
+        deviceOutput >= 0 && deviceOutput < numDeviceChannels) {
+        return patchMatrix[patchIndex(cueOutput, deviceOutput)].load();
     }
     return 0.0f;
 }
@@ -82,23 +142,23 @@ void OutputPatch::clearPatchRouting(int cueOutput, int deviceOutput)
 
 void OutputPatch::clearAllRouting()
 {
-    for (int cueOut = 0; cueOut < MAX_CUE_OUTPUTS; ++cueOut) {
-        for (int deviceOut = 0; deviceOut < MAX_DEVICE_OUTPUTS; ++deviceOut) {
-            patchMatrix[cueOut][deviceOut].store(0.0f);
+    for (int cueOut = 0; cueOut < numCueChannels; ++cueOut) {
+        for (int deviceOut = 0; deviceOut < numDeviceChannels; ++deviceOut) {
+            patchMatrix[patchIndex(cueOut, deviceOut)].store(0.0f);
         }
     }
 }
 
 void OutputPatch::setDeviceOutputLevel(int deviceOutput, float level)
 {
-    if (deviceOutput >= 0 && deviceOutput < MAX_DEVICE_OUTPUTS) {
+    if (deviceOutput >= 0 && deviceOutput < numDeviceChannels) {
         deviceOutputLevels[deviceOutput].store(juce::jlimit(0.0f, 4.0f, level));
     }
 }
 
 float OutputPatch::getDeviceOutputLevel(int deviceOutput) const
 {
-    if (deviceOutput >= 0 && deviceOutput < MAX_DEVICE_OUTPUTS) {
+    if (deviceOutput >= 0 && deviceOutput < numDeviceChannels) {
         return deviceOutputLevels[deviceOutput].load();
     }
     return 0.0f;
@@ -106,14 +166,14 @@ float OutputPatch::getDeviceOutputLevel(int deviceOutput) const
 
 void OutputPatch::muteDeviceOutput(int deviceOutput, bool mute)
 {
-    if (deviceOutput >= 0 && deviceOutput < MAX_DEVICE_OUTPUTS) {
+    if (deviceOutput >= 0 && deviceOutput < numDeviceChannels) {
         deviceOutputMutes[deviceOutput].store(mute);
     }
 }
 
 bool OutputPatch::isDeviceOutputMuted(int deviceOutput) const
 {
-    if (deviceOutput >= 0 && deviceOutput < MAX_DEVICE_OUTPUTS) {
+    if (deviceOutput >= 0 && deviceOutput < numDeviceChannels) {
         return deviceOutputMutes[deviceOutput].load();
     }
     return false;
@@ -124,7 +184,7 @@ void OutputPatch::setDirectRouting()
     clearAllRouting();
     
     // Set 1:1 routing for as many channels as possible
-    int maxChannels = juce::jmin(MAX_CUE_OUTPUTS, MAX_DEVICE_OUTPUTS);
+    int maxChannels = juce::jmin(numCueChannels, numDeviceChannels);
     for (int ch = 0; ch < maxChannels; ++ch) {
         setPatchRouting(ch, ch, 1.0f);
     }
@@ -141,8 +201,8 @@ void OutputPatch::setStereoRouting(int startCueOutput, int startDeviceOutput)
         int deviceLeft = startDeviceOutput + (pair * 2);
         int deviceRight = startDeviceOutput + (pair * 2) + 1;
         
-        if (cueLeft < MAX_CUE_OUTPUTS && cueRight < MAX_CUE_OUTPUTS &&
-            deviceLeft < MAX_DEVICE_OUTPUTS && deviceRight < MAX_DEVICE_OUTPUTS) {
+        if (cueLeft < numCueChannels && cueRight < numCueChannels &&
+            deviceLeft < numDeviceChannels && deviceRight < numDeviceChannels) {
             setPatchRouting(cueLeft, deviceLeft, 1.0f);
             setPatchRouting(cueRight, deviceRight, 1.0f);
         }
@@ -175,7 +235,7 @@ void OutputPatch::resetToDefault()
     clearAllRouting();
     setDirectRouting();
     
-    for (int i = 0; i < MAX_DEVICE_OUTPUTS; ++i) {
+    for (int i = 0; i < numDeviceChannels; ++i) {
         deviceOutputLevels[i].store(1.0f);
         deviceOutputMutes[i].store(false);
     }
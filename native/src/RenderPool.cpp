@@ -0,0 +1,197 @@
+#include "../include/RenderPool.h"
+
+#include <chrono>
+#include <thread>
+
+//==============================================================================
+// Worker
+//==============================================================================
+
+RenderPool::Worker::Worker(RenderPool& owner, int index)
+    : juce::Thread("CueForge Render " + juce::String(index))
+    , pool(owner)
+    , workerIndex(index)
+{
+}
+
+RenderPool::Worker::~Worker()
+{
+    signalThreadShouldExit();
+    wakeUp.signal();
+    stopThread(2000);
+}
+
+void RenderPool::Worker::run()
+{
+    juce::uint32 lastGeneration = pool.generation.load();
+    int idleSpins = 0;
+    juce::uint32 lastBlockMs = juce::Time::getMillisecondCounter();
+
+    while (!threadShouldExit()) {
+        const auto current = pool.generation.load();
+        if (current != lastGeneration) {
+            lastGeneration = current;
+            idleSpins = 0;
+            lastBlockMs = juce::Time::getMillisecondCounter();
+
+            // Register before looking at the ranges so run() cannot reset
+            // them while we are still inside the previous block
+            pool.busyWorkers.fetch_add(1);
+            if (pool.accepting.load() && pool.generation.load() == current) {
+                pool.work(workerIndex);
+            }
+            pool.busyWorkers.fetch_sub(1);
+            continue;
+        }
+
+        if (++idleSpins < SPIN_ITERATIONS) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // While blocks keep coming, nap rather than park so run() never has to signal
+        if (juce::Time::getMillisecondCounter() - lastBlockMs < static_cast<juce::uint32>(ACTIVE_WINDOW_MS)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(NAP_MICROSECONDS));
+            continue;
+        }
+
+        // Idle: park until run() or the destructor signals. Flag first, then
+        // recheck, so a block published in between is never slept through
+        parked.store(true);
+        if (pool.generation.load() == lastGeneration && !threadShouldExit()) {
+            wakeUp.wait(-1);
+        }
+        parked.store(false);
+    }
+}
+
+//==============================================================================
+// RenderPool
+//==============================================================================
+
+RenderPool::RenderPool(int numWorkerThreads)
+    : numWorkers(juce::jlimit(1, MAX_WORKERS, numWorkerThreads + 1))
+    , ranges(new JobRange[static_cast<size_t>(juce::jlimit(1, MAX_WORKERS, numWorkerThreads + 1))])
+{
+    // Keep each worker on its own core, leaving core 0 to the device thread;
+    // with fewer spare cores than workers the scheduler places them instead
+    const int numCores = juce::jmax(1, juce::SystemStats::getNumCpus());
+    const bool pinWorkers = numWorkers <= numCores && numCores <= 32;
+
+    for (int i = 1; i < numWorkers; ++i) {
+        workers.push_back(std::make_unique<Worker>(*this, i));
+
+        if (pinWorkers) {
+            workers.back()->setAffinityMask(1u << static_cast<juce::uint32>(i));
+        }
+        workers.back()->startRealtimeThread(juce::Thread::RealtimeOptions{}.withPriority(9));
+    }
+}
+
+RenderPool::~RenderPool()
+{
+    workers.clear();
+}
+
+void RenderPool::run(int numJobs, JobFunction function, void* context)
+{
+    if (numJobs <= 0) {
+        return;
+    }
+
+    // Deal out contiguous ranges; stealing evens out the cost differences
+    for (int i = 0; i < numWorkers; ++i) {
+        ranges[static_cast<size_t>(i)].top.store((numJobs * i) / numWorkers);
+        ranges[static_cast<size_t>(i)].bottom.store((numJobs * (i + 1)) / numWorkers);
+    }
+
+    jobFunction = function;
+    jobContext = context;
+    remainingJobs.store(numJobs);
+    accepting.store(true);
+    generation.fetch_add(1);
+
+    // Napping workers see the new generation by themselves
+    for (auto& worker : workers) {
+        if (worker->parked.exchange(false)) {
+            worker->wakeUp.signal();
+        }
+    }
+
+    // The audio thread works too, then waits for the stragglers
+    work(0);
+    while (remainingJobs.load() > 0) {
+        std::this_thread::yield();
+    }
+
+    // Close the block and make sure no late worker is still scanning it
+    accepting.store(false);
+    while (busyWorkers.load() > 0) {
+        std::this_thread::yield();
+    }
+}
+
+void RenderPool::work(int workerIndex)
+{
+    int job = 0;
+
+    while (popOwn(workerIndex, job)) {
+        jobFunction(jobContext, job, workerIndex);
+        remainingJobs.fetch_sub(1);
+    }
+
+    // Own range exhausted: steal from the others, starting with our neighbour
+    for (int offset = 1; offset < numWorkers && remainingJobs.load() > 0; ++offset) {
+        const int victim = (workerIndex + offset) % numWorkers;
+        while (steal(victim, job)) {
+            jobFunction(jobContext, job, workerIndex);
+            remainingJobs.fetch_sub(1);
+        }
+    }
+}
+
+bool RenderPool::popOwn(int workerIndex, int& job)
+{
+    auto& range = ranges[static_cast<size_t>(workerIndex)];
+
+    const int bottom = range.bottom.load() - 1;
+    range.bottom.store(bottom);
+    int top = range.top.load();
+
+    if (top < bottom) {
+        job = bottom;
+        return true;
+    }
+
+    if (top == bottom) {
+        // Last job in the range: race any thief for it
+        const int last = top;
+        const bool won = range.top.compare_exchange_strong(top, last + 1);
+        range.bottom.store(last + 1);
+        if (won) {
+            job = bottom;
+        }
+        return won;
+    }
+
+    range.bottom.store(top);
+    return false;
+}
+
+bool RenderPool::steal(int victimIndex, int& job)
+{
+    auto& range = ranges[static_cast<size_t>(victimIndex)];
+
+    for (;;) {
+        int top = range.top.load();
+        const int bottom = range.bottom.load();
+        if (top >= bottom) {
+            return false;
+        }
+
+        if (range.top.compare_exchange_strong(top, top + 1)) {
+            job = top;
+            return true;
+        }
+    }
+}
@@ -0,0 +1,117 @@
+#include "../include/SampleCache.h"
+
+#include <tuple>
+
+bool SampleCache::Key::operator<(const Key& other) const
+{
+    return std::tie(path, modificationTime, fileSize, sampleRate)
+         < std::tie(other.path, other.modificationTime, other.fileSize, other.sampleRate);
+}
+
+bool SampleCache::Key::operator==(const Key& other) const
+{
+    return path == other.path
+        && modificationTime == other.modificationTime
+        && fileSize == other.fileSize
+        && sampleRate == other.sampleRate;
+}
+
+SampleCache::SampleCache()
+{
+}
+
+SampleCache::~SampleCache()
+{
+}
+
+SampleCache::Key SampleCache::makeKey(const juce::File& file, double outputSampleRate)
+{
+    // A file that is edited in place gets a new key, so stale audio is never reused
+    Key key;
+    key.path = file.getFullPathName();
+    key.modificationTime = file.getLastModificationTime().toMilliseconds();
+    key.fileSize = file.getSize();
+    key.sampleRate = outputSampleRate;
+    return key;
+}
+
+SampleCache::SharedBuffer SampleCache::find(const Key& key)
+{
+    juce::ScopedLock scopedLock(lock);
+
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return nullptr;
+    }
+
+    if (auto audio = it->second.lock()) {
+        return audio;
+    }
+
+    entries.erase(it);
+    return nullptr;
+}
+
+SampleCache::SharedBuffer SampleCache::insert(const Key& key, SharedBuffer audio)
+{
+    if (!audio) {
+        return nullptr;
+    }
+
+    juce::ScopedLock scopedLock(lock);
+
+    // Two cues may decode the same file concurrently; the first one wins
+    auto& entry = entries[key];
+    if (auto existing = entry.lock()) {
+        return existing;
+    }
+
+    entry = audio;
+    return audio;
+}
+
+void SampleCache::purge()
+{
+    juce::ScopedLock scopedLock(lock);
+
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.expired()) {
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+int SampleCache::getNumEntries() const
+{
+    juce::ScopedLock scopedLock(lock);
+
+    int count = 0;
+    for (const auto& entry : entries) {
+        if (!entry.second.expired()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+size_t SampleCache::getTotalBytes() const
+{
+    juce::ScopedLock scopedLock(lock);
+
+    size_t total = 0;
+    for (const auto& entry : entries) {
+        if (auto audio = entry.second.lock()) {
+            total += getBufferBytes(*audio);
+        }
+    }
+    return total;
+}
+
+size_t SampleCache::getBufferBytes(const SampleBuffer& audio)
+{
+    return static_cast<size_t>(audio.getNumChannels())
+         * static_cast<size_t>(audio.getNumSamples())
+         * sizeof(float);
+}
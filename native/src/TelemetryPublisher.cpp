@@ -0,0 +1,196 @@
+#include "../include/TelemetryPublisher.h"
+
+#include <cstring>
+
+namespace
+{
+    using SharedWord = std::atomic<juce::int32>;
+    static_assert(sizeof(SharedWord) == sizeof(juce::int32), "sequence word must alias an Int32Array slot");
+
+    enum HeaderWord
+    {
+        sequenceWord = 0,
+        versionWord,
+        numInputsWord,
+        numOutputsWord,
+        numDeviceOutputsWord,
+        maxCuesWord,
+        numCuesWord,
+        generationWord
+    };
+
+    constexpr size_t samplePositionOffset = 32;
+    constexpr size_t sampleRateOffset = 40;
+
+    enum CueFlags
+    {
+        cuePlaying = 1,
+        cuePaused = 2,
+        cueScheduled = 4
+    };
+}
+
+TelemetryPublisher::TelemetryPublisher(AudioEngine& engineToPublish)
+    : juce::Thread("Telemetry Publisher"), engine(engineToPublish)
+{
+}
+
+TelemetryPublisher::~TelemetryPublisher()
+{
+    detach();
+}
+
+size_t TelemetryPublisher::getRequiredBytes(int maxCues) const
+{
+    const auto status = engine.getStatus();
+    const auto meterChannels = static_cast<size_t>(status.numBuses + status.numMixerOutputs + status.numDeviceOutputs);
+    const auto numCues = static_cast<size_t>(juce::jlimit(0, MAX_CUES, maxCues));
+
+    return static_cast<size_t>(HEADER_BYTES)
+         + sizeof(float) * (meterChannels * METER_FLOATS + numCues * CUE_FLOATS);
+}
+
+bool TelemetryPublisher::attach(void* data, size_t numBytes, int maxCues)
+{
+    detach();
+
+    if (data == nullptr || maxCues < 0 || maxCues > MAX_CUES || numBytes < getRequiredBytes(maxCues)) {
+        return false;
+    }
+
+    {
+        juce::ScopedLock lock(bufferLock);
+
+        const auto status = engine.getStatus();
+        buffer = static_cast<juce::uint8*>(data);
+        bufferBytes = numBytes;
+        cueCapacity = maxCues;
+        numInputs = status.numBuses;
+        numOutputs = status.numMixerOutputs;
+        numDeviceOutputs = status.numDeviceOutputs;
+
+        // The layout is fixed for the life of the attachment
+        std::memset(buffer, 0, bufferBytes);
+        auto* header = reinterpret_cast<juce::int32*>(buffer);
+        header[versionWord] = LAYOUT_VERSION;
+        header[numInputsWord] = numInputs;
+        header[numOutputsWord] = numOutputs;
+        header[numDeviceOutputsWord] = numDeviceOutputs;
+        header[maxCuesWord] = cueCapacity;
+    }
+
+    {
+        juce::ScopedLock lock(slotLock);
+        slotIds.clear();
+    }
+
+    publish();
+    startThread();
+    return true;
+}
+
+void TelemetryPublisher::detach()
+{
+    stopThread(1000);
+
+    juce::ScopedLock lock(bufferLock);
+    buffer = nullptr;
+    bufferBytes = 0;
+    cueCapacity = 0;
+}
+
+void TelemetryPublisher::setIntervalMs(int newIntervalMs)
+{
+    intervalMs.store(juce::jlimit(1, 1000, newIntervalMs));
+}
+
+juce::StringArray TelemetryPublisher::getCueIds(juce::int32& generation) const
+{
+    juce::ScopedLock lock(slotLock);
+    generation = slotGeneration;
+    return slotIds;
+}
+
+void TelemetryPublisher::run()
+{
+    while (!threadShouldExit()) {
+        publish();
+        wait(intervalMs.load());
+    }
+}
+
+void TelemetryPublisher::updateCueSlots()
+{
+    const int numCues = juce::jmin(static_cast<int>(playheads.size()), cueCapacity);
+
+    bool changed = numCues != slotIds.size();
+    for (int slot = 0; !changed && slot < numCues; ++slot) {
+        changed = playheads[static_cast<size_t>(slot)].cueId != slotIds[slot];
+    }
+
+    if (changed) {
+        juce::ScopedLock lock(slotLock);
+        slotIds.clearQuick();
+        for (int slot = 0; slot < numCues; ++slot) {
+            slotIds.add(playheads[static_cast<size_t>(slot)].cueId);
+        }
+        ++slotGeneration;
+    }
+}
+
+void TelemetryPublisher::publish()
+{
+    juce::ScopedLock lock(bufferLock);
+    if (buffer == nullptr) {
+        return;
+    }
+
+    // Gather first so the write window JS can collide with stays short
+    engine.getMeters(meters);
+    engine.getPlayheads(playheads);
+    updateCueSlots();
+
+    auto* header = reinterpret_cast<juce::int32*>(buffer);
+    auto& sequence = *reinterpret_cast<SharedWord*>(header + sequenceWord);
+    const juce::int32 start = sequence.load(std::memory_order_relaxed);
+
+    sequence.store(start + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const int numCues = slotIds.size();
+    header[numCuesWord] = numCues;
+    header[generationWord] = slotGeneration;
+
+    const double clock = static_cast<double>(engine.getSamplePosition());
+    const double sampleRate = engine.getSampleRate();
+    std::memcpy(buffer + samplePositionOffset, &clock, sizeof(double));
+    std::memcpy(buffer + sampleRateOffset, &sampleRate, sizeof(double));
+
+    auto* values = reinterpret_cast<float*>(buffer + HEADER_BYTES);
+    auto writeMeters = [&values](const std::vector<MeterBank::Level>& levels, int numChannels) {
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const auto level = channel < static_cast<int>(levels.size()) ? levels[static_cast<size_t>(channel)]
+                                                                         : MeterBank::Level();
+            *values++ = level.peak;
+            *values++ = level.rms;
+            *values++ = level.peakHold;
+        }
+    };
+
+    writeMeters(meters.inputs, numInputs);
+    writeMeters(meters.outputs, numOutputs);
+    writeMeters(meters.deviceOutputs, numDeviceOutputs);
+
+    for (int slot = 0; slot < numCues; ++slot) {
+        const auto& playhead = playheads[static_cast<size_t>(slot)];
+        const int flags = (playhead.playing ? cuePlaying : 0)
+                        | (playhead.paused ? cuePaused : 0)
+                        | (playhead.scheduled ? cueScheduled : 0);
+
+        *values++ = static_cast<float>(playhead.currentTime);
+        *values++ = static_cast<float>(playhead.duration);
+        *values++ = static_cast<float>(flags);
+    }
+
+    sequence.store(start + 2, std::memory_order_release);
+}
@@ -0,0 +1,222 @@
+#include "../include/TraceRecorder.h"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+std::atomic<bool> TraceRecorder::recording{false};
+thread_local TraceRecorder::ThreadClaim TraceRecorder::threadClaim;
+
+namespace
+{
+    juce::String quote(const char* text)
+    {
+        return juce::JSON::toString(juce::var(juce::String(juce::CharPointer_UTF8(text))));
+    }
+}
+
+TraceRecorder& TraceRecorder::getInstance()
+{
+    static TraceRecorder instance;
+    return instance;
+}
+
+void TraceRecorder::start()
+{
+    const juce::ScopedLock lock(controlLock);
+
+    // The pool lives as long as the recorder, since threads keep pointers into it
+    if (buffers == nullptr) {
+        buffers.reset(new ThreadBuffer[MAX_THREADS]);
+        bufferPool.store(buffers.get(), std::memory_order_release);
+    }
+
+    // Leave everything recorded so far out of the new capture, and free the
+    // rings of threads that have exited since the last one
+    for (int index = 0; index < MAX_THREADS; ++index) {
+        ThreadBuffer& buffer = buffers[index];
+        buffer.captureStart = buffer.writeIndex.load(std::memory_order_acquire);
+
+        if (buffer.state.load(std::memory_order_acquire) == slotReleased) {
+            buffer.named.store(false, std::memory_order_relaxed);
+            std::fill(std::begin(buffer.threadName), std::end(buffer.threadName), '\0');
+            buffer.state.store(slotFree, std::memory_order_release);
+        }
+    }
+    droppedThreads.store(0);
+    captureNumber.fetch_add(1);
+    captureStartTicks = juce::Time::getHighResolutionTicks();
+    recording.store(true);
+}
+
+void TraceRecorder::stop()
+{
+    recording.store(false);
+}
+
+TraceRecorder::ThreadClaim::~ThreadClaim()
+{
+    // The pool outlives every thread, so the ring can always be handed back
+    if (buffer != nullptr) {
+        buffer->state.store(slotReleased, std::memory_order_release);
+    }
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::getThreadBuffer()
+{
+    if (threadClaim.buffer != nullptr) {
+        return threadClaim.buffer;
+    }
+
+    // A thread that found the pool full waits for the next capture to retry
+    ThreadBuffer* pool = bufferPool.load(std::memory_order_acquire);
+    const juce::uint32 capture = captureNumber.load();
+    if (pool == nullptr || threadClaim.failedCapture == capture) {
+        return nullptr;
+    }
+
+    for (int index = 0; index < MAX_THREADS; ++index) {
+        ThreadBuffer* buffer = pool + index;
+        int expected = slotFree;
+        if (!buffer->state.compare_exchange_strong(expected, slotClaimed, std::memory_order_acq_rel)) {
+            continue;
+        }
+
+        if (auto* thread = juce::Thread::getCurrentThread()) {
+            thread->getThreadName().copyToUTF8(buffer->threadName, THREAD_NAME_BYTES);
+            buffer->named.store(true, std::memory_order_release);
+        }
+
+        threadClaim.buffer = buffer;
+        return buffer;
+    }
+
+    threadClaim.failedCapture = capture;
+    droppedThreads.fetch_add(1);
+    return nullptr;
+}
+
+void TraceRecorder::setThreadName(const char* name)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+    if (buffer == nullptr || buffer->named.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    juce::String(juce::CharPointer_UTF8(name)).copyToUTF8(buffer->threadName, THREAD_NAME_BYTES);
+    buffer->named.store(true, std::memory_order_release);
+}
+
+void TraceRecorder::push(ThreadBuffer& buffer, const char* category, const char* name,
+                         juce::int64 startTicks, juce::int64 endTicks, juce::int64 value)
+{
+    // Seqlock-style: announce the overwrite, fill the slot, then publish it
+    const juce::uint64 index = buffer.writeIndex.load(std::memory_order_relaxed);
+    buffer.startedIndex.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    TraceEvent& event = buffer.events[index & (EVENTS_PER_THREAD - 1)];
+    event.category.store(category, std::memory_order_relaxed);
+    event.name.store(name, std::memory_order_relaxed);
+    event.startTicks.store(startTicks, std::memory_order_relaxed);
+    event.endTicks.store(endTicks, std::memory_order_relaxed);
+    event.value.store(value, std::memory_order_relaxed);
+
+    buffer.writeIndex.store(index + 1, std::memory_order_release);
+}
+
+void TraceRecorder::addSpan(const char* category, const char* name, juce::int64 startTicks, juce::int64 endTicks,
+                            juce::int64 value)
+{
+    if (!isRecording()) {
+        return;
+    }
+    if (ThreadBuffer* buffer = getThreadBuffer()) {
+        push(*buffer, category, name, startTicks, endTicks, value);
+    }
+}
+
+void TraceRecorder::addInstant(const char* category, const char* name, juce::int64 value)
+{
+    if (!isRecording()) {
+        return;
+    }
+    if (ThreadBuffer* buffer = getThreadBuffer()) {
+        const juce::int64 now = juce::Time::getHighResolutionTicks();
+        push(*buffer, category, name, now, now, value);
+    }
+}
+
+int TraceRecorder::writeChromeTrace(juce::OutputStream& output) const
+{
+    const juce::ScopedLock lock(controlLock);
+
+    const double microsPerTick = 1.0e6 / static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+    const int numBuffers = buffers != nullptr ? MAX_THREADS : 0;
+    int numEvents = 0;
+
+    output << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedThreads\":" << droppedThreads.load()
+           << "},\"traceEvents\":[\n"
+           << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CueForge Engine\"}}";
+
+    for (int thread = 0; thread < numBuffers; ++thread) {
+        const ThreadBuffer& buffer = buffers[thread];
+        const int tid = thread + 1;
+        if (buffer.state.load(std::memory_order_acquire) == slotFree) {
+            continue;
+        }
+
+        const juce::String threadName = buffer.named.load(std::memory_order_acquire)
+                                      ? juce::String(juce::CharPointer_UTF8(buffer.threadName))
+                                      : "Thread " + juce::String(tid);
+        output << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+               << ",\"args\":{\"name\":" << juce::JSON::toString(threadName) << "}}";
+
+        // Copy the newest ring's worth, then drop whatever the writer lapped meanwhile
+        const juce::uint64 end = buffer.writeIndex.load(std::memory_order_acquire);
+        juce::uint64 begin = juce::jmax(buffer.captureStart,
+                                        end > EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : juce::uint64(0));
+
+        struct Copy { const char* category; const char* name; juce::int64 startTicks, endTicks, value; };
+        std::vector<Copy> copies;
+        copies.reserve(static_cast<size_t>(end - begin));
+        for (juce::uint64 index = begin; index < end; ++index) {
+            const TraceEvent& event = buffer.events[index & (EVENTS_PER_THREAD - 1)];
+            copies.push_back({ event.category.load(std::memory_order_relaxed),
+                               event.name.load(std::memory_order_relaxed),
+                               event.startTicks.load(std::memory_order_relaxed),
+                               event.endTicks.load(std::memory_order_relaxed),
+                               event.value.load(std::memory_order_relaxed) });
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const juce::uint64 started = buffer.startedIndex.load(std::memory_order_relaxed);
+        const juce::uint64 firstIntact = started > EVENTS_PER_THREAD ? started - EVENTS_PER_THREAD : 0;
+
+        for (juce::uint64 index = juce::jmax(begin, firstIntact); index < end; ++index) {
+            const Copy& event = copies[static_cast<size_t>(index - begin)];
+            if (event.name == nullptr || event.endTicks < captureStartTicks) {
+                continue;
+            }
+
+            const double timestamp = static_cast<double>(event.startTicks - captureStartTicks) * microsPerTick;
+            output << ",\n{\"name\":" << quote(event.name)
+                   << ",\"cat\":" << quote(event.category != nullptr ? event.category : "")
+                   << ",\"pid\":1,\"tid\":" << tid
+                   << ",\"ts\":" << juce::String(timestamp, 3);
+
+            if (event.endTicks == event.startTicks) {
+                output << ",\"ph\":\"i\",\"s\":\"t\"";
+            } else {
+                const double duration = static_cast<double>(event.endTicks - event.startTicks) * microsPerTick;
+                output << ",\"ph\":\"X\",\"dur\":" << juce::String(duration, 3);
+            }
+
+            output << ",\"args\":{\"value\":" << event.value << "}}";
+            ++numEvents;
+        }
+    }
+
+    output << "\n]}\n";
+    return numEvents;
+}
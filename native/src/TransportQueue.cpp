@@ -0,0 +1,39 @@
+#include "../include/TransportQueue.h"
+
+TransportQueue::TransportQueue(int capacity)
+    : fifo(juce::jmax(2, capacity))
+    , commands(static_cast<size_t>(juce::jmax(2, capacity)))
+{
+}
+
+TransportQueue::~TransportQueue()
+{
+}
+
+bool TransportQueue::push(const TransportCommand& command)
+{
+    const auto scope = fifo.write(1);
+    if (scope.blockSize1 > 0) {
+        commands[static_cast<size_t>(scope.startIndex1)] = command;
+        return true;
+    }
+    if (scope.blockSize2 > 0) {
+        commands[static_cast<size_t>(scope.startIndex2)] = command;
+        return true;
+    }
+    return false; // Full: the caller reports the command as rejected
+}
+
+bool TransportQueue::pop(TransportCommand& command)
+{
+    const auto scope = fifo.read(1);
+    if (scope.blockSize1 > 0) {
+        command = commands[static_cast<size_t>(scope.startIndex1)];
+        return true;
+    }
+    if (scope.blockSize2 > 0) {
+        command = commands[static_cast<size_t>(scope.startIndex2)];
+        return true;
+    }
+    return false;
+}
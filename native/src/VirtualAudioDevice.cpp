@@ -0,0 +1,157 @@
+#include "../include/VirtualAudioDevice.h"
+
+#include <cmath>
+
+VirtualAudioDevice::VirtualAudioDevice(const Settings& deviceSettings)
+    : juce::AudioIODevice(DEVICE_NAME, TYPE_NAME)
+    , juce::Thread("CueForge Virtual Device")
+    , settings(deviceSettings)
+{
+    currentSampleRate = settings.sampleRate;
+    currentBufferSize = settings.bufferSize;
+}
+
+VirtualAudioDevice::~VirtualAudioDevice()
+{
+    close();
+}
+
+juce::StringArray VirtualAudioDevice::getOutputChannelNames()
+{
+    juce::StringArray names;
+    for (int channel = 0; channel < juce::jlimit(1, MAX_OUTPUTS, settings.numOutputs); ++channel) {
+        names.add("Virtual Out " + juce::String(channel + 1));
+    }
+    return names;
+}
+
+juce::Array<double> VirtualAudioDevice::getAvailableSampleRates()
+{
+    juce::Array<double> rates { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+    rates.addIfNotAlreadyThere(settings.sampleRate);
+    return rates;
+}
+
+juce::Array<int> VirtualAudioDevice::getAvailableBufferSizes()
+{
+    juce::Array<int> sizes;
+    for (int size = 16; size <= 4096; size *= 2) {
+        sizes.add(size);
+    }
+    sizes.addIfNotAlreadyThere(settings.bufferSize);
+    return sizes;
+}
+
+juce::String VirtualAudioDevice::open(const juce::BigInteger& inputChannels, const juce::BigInteger& outputChannels,
+                                      double sampleRate, int bufferSizeSamples)
+{
+    juce::ignoreUnused(inputChannels);
+    close();
+
+    currentSampleRate = sampleRate > 0.0 ? sampleRate : settings.sampleRate;
+    currentBufferSize = bufferSizeSamples > 0 ? bufferSizeSamples : settings.bufferSize;
+
+    const int numChannels = getOutputChannelNames().size();
+    activeOutputs = outputChannels;
+    activeOutputs.setRange(numChannels, juce::jmax(0, activeOutputs.getHighestBit() + 1 - numChannels), false);
+
+    outputBuffer.setSize(juce::jmax(1, activeOutputs.countNumberOfSetBits()), currentBufferSize);
+    deviceOpen = true;
+    return {};
+}
+
+void VirtualAudioDevice::close()
+{
+    stop();
+    deviceOpen = false;
+}
+
+void VirtualAudioDevice::start(juce::AudioIODeviceCallback* newCallback)
+{
+    if (!deviceOpen || newCallback == nullptr) {
+        return;
+    }
+
+    stop();
+    newCallback->audioDeviceAboutToStart(this);
+    callback = newCallback;
+
+    const double periodMs = 1000.0 * currentBufferSize / currentSampleRate;
+    startRealtimeThread(juce::Thread::RealtimeOptions{}.withPriority(9).withPeriodMs(periodMs));
+}
+
+void VirtualAudioDevice::stop()
+{
+    stopThread(2000);
+
+    juce::AudioIODeviceCallback* oldCallback = callback;
+    callback = nullptr;
+
+    if (oldCallback != nullptr) {
+        oldCallback->audioDeviceStopped();
+    }
+}
+
+void VirtualAudioDevice::run()
+{
+    const double periodMs = 1000.0 * currentBufferSize / currentSampleRate;
+    const int numChannels = outputBuffer.getNumChannels();
+    juce::Random random;
+
+    // Deadlines advance by whole periods from the start, so the average rate
+    // is exact however late an individual callback runs
+    double deadline = juce::Time::getMillisecondCounterHiRes() + periodMs;
+
+    while (!threadShouldExit()) {
+        const double jitter = settings.jitterMs > 0.0 ? random.nextDouble() * settings.jitterMs : 0.0;
+        const double wakeTime = deadline + jitter;
+
+        // Sleep most of the way, then spin for an accurate wake-up
+        double remaining = wakeTime - juce::Time::getMillisecondCounterHiRes();
+        if (remaining > 2.0) {
+            wait(static_cast<int>(remaining - 1.0));
+        }
+        while (!threadShouldExit() && juce::Time::getMillisecondCounterHiRes() < wakeTime) {
+            juce::Thread::yield();
+        }
+
+        callback->audioDeviceIOCallbackWithContext(nullptr, 0, outputBuffer.getArrayOfWritePointers(),
+                                                   numChannels, currentBufferSize, {});
+
+        // After a stall, skip the missed periods like a driver would
+        deadline += periodMs;
+        const double now = juce::Time::getMillisecondCounterHiRes();
+        if (now > deadline + periodMs) {
+            deadline += std::floor((now - deadline) / periodMs) * periodMs;
+        }
+    }
+}
+
+VirtualAudioDeviceType::VirtualAudioDeviceType()
+    : juce::AudioIODeviceType(VirtualAudioDevice::TYPE_NAME)
+{
+}
+
+juce::StringArray VirtualAudioDeviceType::getDeviceNames(bool wantInputNames) const
+{
+    if (wantInputNames) {
+        return {};
+    }
+    return juce::StringArray(VirtualAudioDevice::DEVICE_NAME);
+}
+
+int VirtualAudioDeviceType::getIndexOfDevice(juce::AudioIODevice* device, bool asInput) const
+{
+    return !asInput && dynamic_cast<VirtualAudioDevice*>(device) != nullptr ? 0 : -1;
+}
+
+juce::AudioIODevice* VirtualAudioDeviceType::createDevice(const juce::String& outputDeviceName,
+                                                          const juce::String& inputDeviceName)
+{
+    juce::ignoreUnused(inputDeviceName);
+
+    if (outputDeviceName.isNotEmpty() && outputDeviceName != VirtualAudioDevice::DEVICE_NAME) {
+        return nullptr;
+    }
+    return new VirtualAudioDevice(settings);
+}